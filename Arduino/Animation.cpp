@@ -32,28 +32,30 @@
 #include "Animation.h"
 #include <Adafruit_NeoPixel.h>
 #include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+#include "AnimationArena.h"
 
 /************************************************************************************
  * table of colors used by animations and randomColor()
  ************************************************************************************/
-#define colorTableSize 15             // # colors in table
-uint32_t colors[colorTableSize] = {
-  pixels.Color(255,200,100),          // white-ish      0
-  pixels.Color(0x00, 0x80, 0x00),     // pale green     1
-  pixels.Color(0xFF, 0x00, 0x52),     // rosy           2
-  pixels.Color(0x00, 0x00, 0x80),     // light blue     3
-  pixels.Color(255, 255, 0),          // yellow         4
-  pixels.Color(255, 0, 255),          // magenta        5
-  pixels.Color(0, 255, 255),          // cyan           6
-  pixels.Color(0x9E, 0x1E, 0x00),     // orange         7
-  pixels.Color(0x77, 0x00, 0xA9),     // violet         8
-  pixels.Color(0x00, 0x85, 0x82),     // pale cyan      9
-  pixels.Color(0xFF, 0x44, 0x44),     // pink-ish      10
-  pixels.Color(50, 50, 128),          // dimPaleBlue   11
-  pixels.Color(0, 0xDD, 0x15),        // mostly green  12
-  pixels.Color(128, 128, 255),        // pale blue     13
-  pixels.Color(120, 0, 0)             // redish        14
+const uint32_t colors[] = {
+  rgbColor(255,200,100),              // white-ish      0
+  rgbColor(0x00, 0x80, 0x00),         // pale green     1
+  rgbColor(0xFF, 0x00, 0x52),         // rosy           2
+  rgbColor(0x00, 0x00, 0x80),         // light blue     3
+  rgbColor(255, 255, 0),              // yellow         4
+  rgbColor(255, 0, 255),              // magenta        5
+  rgbColor(0, 255, 255),              // cyan           6
+  rgbColor(0x9E, 0x1E, 0x00),         // orange         7
+  rgbColor(0x77, 0x00, 0xA9),         // violet         8
+  rgbColor(0x00, 0x85, 0x82),         // pale cyan      9
+  rgbColor(0xFF, 0x44, 0x44),         // pink-ish      10
+  rgbColor(50, 50, 128),              // dimPaleBlue   11
+  rgbColor(0, 0xDD, 0x15),            // mostly green  12
+  rgbColor(128, 128, 255),            // pale blue     13
+  rgbColor(120, 0, 0)                // redish        14
 };
+const int colorTableSize = tableCount(colors);   // # colors in table
 
 /************************************************************************************
  * pick an random color (and check it's not the same as last time)
@@ -73,12 +75,12 @@ uint32_t Animation::randomColor() {
  * including _firstLED and _lastLED
  ************************************************************************************/
 void Animation::setAllPixelsTo(uint32_t aColor, bool doShow) {
-//  pixels.fill(aColor, _firstLED, pixels.numPixels()-2);
+//  pixels.fill(aColor, _firstLED, frame.numPixels()-2);
   for (int i=_firstLED; i<=_lastLED; i++) {
-    pixels.setPixelColor(i, aColor);
+    frame.setPixelColor(i, aColor);
   }
   if (doShow) {
-    pixels.show();
+    frame.show();
   }
 }
 
@@ -99,17 +101,28 @@ void Animation::setAllPixelsTo(uint32_t aColor, bool doShow) {
  * complete when it returns, but it may just initiate another phase of the animation.
  * 
  * Active() returns true if the animation is executing.
+ *
+ * Joined() is called when someone else comes onto the stairs while the animation
+ * is showing; animations that light only part of the stairs light the rest.
+ *
+ * setSegment() confines the next Start() to one flight of the stairs. The time
+ * between steps stays as it was, so a short flight is done sooner.
+ *
+ * Deterministic() is true for animations whose frames depend only on the time
+ * (animationMillis(), never millis()) and what Start() was given; those can be
+ * drawn ahead of time (see RenderAhead.h).
  ************************************************************************************/
 Animation::Animation(const char * animationName, float animationTime, int firstOffset, int lastOffset) {
    _animationTime = animationTime;
    if (_animationTime > 0) {      // this calculation assumes time to execute code is negliable
-     float waitFraction = animationTime/float(pixels.numPixels()-2);
+     float waitFraction = animationTime/float(frame.numPixels()-2);
      _animationStepIncrement = int(round(waitFraction*1000));
    } else {
      _animationStepIncrement = -int(round(_animationTime));
    }
-   _firstLED = firstOffset;
-   _lastLED = pixels.numPixels()-1+lastOffset;
+   _firstOffset = firstOffset;
+   _lastOffset = lastOffset;
+   setSegment(0, frame.numPixels()-1);
    _name = animationName;
 }
 
@@ -128,10 +141,39 @@ void Animation::Finish(bool topToBottom) {
   Serial.println("virtual Animation::Finish should never be called");
 }
 
+void Animation::setSegment(int first, int last) {
+  _firstLED = first+_firstOffset;
+  _lastLED = last+_lastOffset;
+}
+
+void Animation::Joined(bool fromTop) {
+  (void)fromTop;                          // most animations light all the stairs anyway
+}
+
+bool Animation::Deterministic() {
+  return false;                           // random colors, or just not checked
+}
+
+void *Animation::claimState(size_t bytes) {
+  return animationArena.claim(this, bytes);
+}
+
+void Animation::releaseState() {
+  animationArena.release(this);
+}
+
+bool Animation::holdsState() {
+  return animationArena.holds(this);
+}
+
 bool Animation::Active() {
   return _active;
 }
 
+float Animation::animationTime() {
+  return _animationTime;
+}
+
 void Animation::printSelf() {
   Serial.print(_name); Serial.print(": "); Serial.println(_animationStepIncrement);
 }
@@ -165,7 +207,7 @@ void Startup::Continue() {
   if (!_active) {                           // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {  // appropriate time elapsed?
     return;                                 // not yet
@@ -174,8 +216,8 @@ void Startup::Continue() {
   if (aColor != 0) {
     aColor = colors[_colorIdx];
   }
-  pixels.setPixelColor(_idx, aColor);
-  pixels.show();
+  frame.setPixelColor(_idx, aColor);
+  frame.show();
   _idx += _inc;
   if ((_idx < _firstLED) || (_idx > _lastLED)) {
     _active = false;
@@ -69,6 +69,20 @@
  * complete when it returns, but it may just initiate another phase of the animation.
  * 
  * Active() returns true if the animation is executing.
+ *
+ * Joined() is called when someone else comes onto the stairs while the animation
+ * is showing; animations that light only part of the stairs light the rest.
+ *
+ * setSegment() confines the next Start() to one flight of the stairs. The time
+ * between steps stays as it was, so a short flight is done sooner.
+ *
+ * Deterministic() is true for animations whose frames depend only on the time
+ * (animationMillis(), never millis()) and what Start() was given; those can be
+ * drawn ahead of time (see RenderAhead.h).
+ *
+ * Animations with working state the size of the strip keep it in the animation
+ * arena (AnimationArena.h) while they're active: claimState() in Start(),
+ * releaseState() once Finish() is done.
  ************************************************************************************/
  class Animation {
   public:
@@ -76,7 +90,11 @@
     virtual void Start(bool topToBottom, uint32_t colorToUse);  // Initate animation
     virtual void Continue() = 0;          // keep animation going
     virtual void Finish(bool topToBottom);  // initiate completion of animation
+    virtual void Joined(bool fromTop);    // another walker, from the top or bottom
+    virtual bool Deterministic();         // can frames be drawn before they're due?
+    void setSegment(int first, int last); // LEDs first..last (indicators included) rather than the whole strip
     bool Active();                        // is the animation currently active?
+    float animationTime();                // as constructed; <0 is a step time, not a total
     void printSelf();                     // print animation name and _animationStepIncrement
 
     uint32_t randomColor();               // returns a random color from colors[] table (see .cpp file)
@@ -85,6 +103,8 @@
     const char * _name = "Base class";    // name of animation
     int _firstLED;                        // address of 1st pixel in strip we can use
     int _lastLED;                         // address of last pixel in strip we can use
+    int _firstOffset;                     // _firstLED & _lastLED relative to the segment's ends
+    int _lastOffset;
     bool _active;                         // true if animation is currently displaying something
     uint32_t _colorToUse;                 // suggested color to use
     bool _topToBottom;                    // animation clue, start animation from top
@@ -94,6 +114,9 @@
     int _lastColorIndex;                  // used by randomColor()
  
     void setAllPixelsTo(uint32_t aColor, bool doShow=true);   // like .fill() except that goes between first & last
+    void *claimState(size_t bytes);       // zeroed working state in the arena, NULL if it won't fit
+    void releaseState();
+    bool holdsState();                    // false once another animation has claimed the arena
 };
 
 /************************************************************************************
@@ -0,0 +1,70 @@
+/*!
+ * @file AnimationArena.cpp
+ *
+ * @mainpage Arduino library for the working state of the running animation
+ *
+ * @section intro_sec Introduction
+ *
+ * The arena and the list of states it's sized for.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * AnimationArena.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "AnimationArena.h"
+#include "Twinkle.h"
+#include "Particles.h"
+
+// a member for each animation state that's kept in the arena
+union AnimationStates {
+  TwinkleState twinkle;
+  ParticleState particles;
+};
+
+alignas(AnimationStates) static uint8_t arenaBytes[sizeof(AnimationStates)];
+
+AnimationArena animationArena;
+
+AnimationArena::AnimationArena() {
+  _owner = NULL;
+}
+
+void *AnimationArena::claim(const void *owner, size_t bytes) {
+  if (bytes > sizeof(arenaBytes)) {
+    return NULL;
+  }
+  _owner = owner;
+  memset(arenaBytes, 0, bytes);
+  return arenaBytes;
+}
+
+void AnimationArena::release(const void *owner) {
+  if (_owner == owner) {
+    _owner = NULL;
+  }
+}
+
+bool AnimationArena::holds(const void *owner) {
+  return (owner != NULL) && (_owner == owner);
+}
+
+size_t AnimationArena::capacity() {
+  return sizeof(arenaBytes);
+}
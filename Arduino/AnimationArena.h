@@ -0,0 +1,63 @@
+/*!
+ * @file AnimationArena.h
+ *
+ * @mainpage Arduino library for the working state of the running animation
+ *
+ * @section intro_sec Introduction
+ *
+ * Only one animation runs at a time, but every one of them is a global,
+ * and those with working state the size of the strip (Twinkle's LEDs,
+ * the particle engines' particles) would each hold it all the time.
+ * Instead they keep only their parameters, and claim the arena for their
+ * working state in Start(), releasing it when Finish() is done. The
+ * arena is as big as the largest of those states, not their sum, which
+ * is what leaves room for a longer strip on the M0.
+ *
+ * The arena has one owner. A claim by another animation takes it over;
+ * the one that had it finds it no longer holds it and stops. The states
+ * it must hold are listed in AnimationArena.cpp.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * AnimationArena.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef AnimationArena_h
+#define AnimationArena_h
+
+/************************************************************************************
+ * one global instance, animationArena; animations use it through Animation's
+ * claimState(), releaseState() and holdsState()
+ ************************************************************************************/
+class AnimationArena {
+  public:
+    AnimationArena();
+    void *claim(const void *owner, size_t bytes);   // zeroed; NULL if bytes > capacity()
+    void release(const void *owner);      // only if owner still holds it
+    bool holds(const void *owner);
+    size_t capacity();
+
+  private:
+    const void *_owner;                   // NULL when free
+};
+
+extern AnimationArena animationArena;
+
+#endif
@@ -36,16 +36,59 @@
 // There's probably a better way of doing all of this, I just haven't figured
 // it out yet.
 
+#ifndef kNumberOfLEDs                     // (host builds may choose their own)
 #define kNumberOfLEDs 111                 // # of LEDs in our NeoPixel strip
+#endif
+// bits per LED in the palette frame (PaletteFrame.h), 4 or 8. 8 costs ~2.3 KB of
+// palette tables, more than a short strip saves. Either way the frame is RAM on top
+// of Adafruit_NeoPixel's own 3 bytes per LED: for 111 LEDs at 4 bits its indices
+// and palette are 200 bytes and the whole PaletteFrame (with the pattern and the
+// layers) about 950, next to the strip's 333
+#ifndef kFrameBitsPerPixel
+#define kFrameBitsPerPixel 4
+#endif
+
+// same packing as Adafruit_NeoPixel::Color(), but usable at compile time so
+// color tables can be constant (and live in flash rather than RAM)
+constexpr uint32_t rgbColor(uint8_t r, uint8_t g, uint8_t b) {
+  return (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
+}
+
+// sum of a color's channels, 0..765; the current a pixel draws is roughly
+// proportional to it
+constexpr uint16_t colorWeight(uint32_t aColor) {
+  return ((aColor >> 16) & 0xFF) + ((aColor >> 8) & 0xFF) + (aColor & 0xFF);
+}
+
+// write aColor as GRB bytes scaled by a 16 bit brightness level. dither (0..65535)
+// decides how the fraction is rounded; varying it from frame to frame makes the
+// average over frames aColor*(level+1)/65536 (temporal dithering). Full level is
+// exactly aColor.
+inline void scaleColorToGRB(uint32_t aColor, uint16_t level, uint16_t dither, uint8_t *grb) {
+  uint32_t scale = uint32_t(level) + 1;
+  grb[0] = (((aColor >> 8) & 0xFF) * scale + dither) >> 16;    // green
+  grb[1] = (((aColor >> 16) & 0xFF) * scale + dither) >> 16;   // red
+  grb[2] = ((aColor & 0xFF) * scale + dither) >> 16;           // blue
+}
+
+// number of entries in a table, worked out by the compiler
+template <typename T, size_t N>
+constexpr int tableCount(T (&)[N]) {
+  return int(N);
+}
 
 // the following definitions _must_ exist elsewhere in the project
 // as shipped, they are defined in the stairway file.
 
-extern uint32_t indicatorColor;           // color to use for PIR indicators
-extern uint32_t offColor;                 // offColor (black)
-extern Adafruit_NeoPixel pixels;          // the strip of NeoPixels
+extern const uint32_t indicatorColor;     // color to use for PIR indicators
+extern const uint32_t offColor;           // offColor (black)
+class PaletteFrame;
+extern PaletteFrame frame;                // what the animations draw into
+class StairGeometry;
+extern StairGeometry geometry;            // where the steps are, how fast people walk
 
 extern uint32_t randomColor();            // returns a color from colors[]
+extern unsigned long animationMillis();   // millis() for the animations (see RenderAhead.h)
 extern int mappedBrightness(); // returns a brightness level to use
 
 #endif
@@ -38,6 +38,9 @@
 #include <Adafruit_NeoPixel.h>
 #include "ColorSwirl.h"
 #include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+
+#define swirlPeriod 64              // # of wheel colors in the rainbow pattern
 
 /************************************************************************************
  * Recast of Adafruit CircuitPython function to light the LEDs with a rainbow like
@@ -53,30 +56,36 @@ uint32_t ColorSwirl::wheel(int pos) {
     return offColor;
   }
   if (pos < 85) {
-    return pixels.Color(255-pos*3, pos*3, 0);
+    return rgbColor(255-pos*3, pos*3, 0);
   }
   if (pos < 170) {
     pos -= 85;
-    return pixels.Color(0, 255-pos*3, pos*3);
+    return rgbColor(0, 255-pos*3, pos*3);
   }
   pos -= 170;
-  return pixels.Color(pos*3, 0, 255-pos*3);
+  return rgbColor(pos*3, 0, 255-pos*3);
 }
 
-// start up the animation
+// start up the animation; the rainbow is one period of the frame's pattern stretched
+// over the strip, so a swirl step is just a change of phase
 void ColorSwirl::Start(bool topToBottom, uint32_t colorToUse) {
   _topToBottom = topToBottom;                 // not used, compiler happiness
   _colorToUse = colorToUse;                   // ditto
   _active = true;
   _swirlIdx = 0;
   _swirlInc = 1;
-  pixels.setBrightness(255);
-  for (int i=_firstLED; i<=_lastLED; i++) {
-    int rc_index = (i*256/(_lastLED-_firstLED)) + _swirlIdx;
-    pixels.setPixelColor(i, wheel(rc_index & 255));
+  frame.setBrightness(255);
+  PeriodicPattern &rainbow = frame.pattern();
+  int span = max(_lastLED-_firstLED, 1);
+  rainbow.setPeriod(swirlPeriod, (swirlPeriod*256)/span);   // whole wheel across the strip
+  for (int i=0; i<swirlPeriod; i++) {
+    rainbow.setEntry(i, wheel(i*256/swirlPeriod));
   }
-  pixels.show();
-  _lastUpdateTime = millis();
+  _swirlPhase = long(_firstLED)*swirlPeriod*256/span;      // pixel i starts at wheel(i*256/span)
+  rainbow.setPhase(_swirlPhase);
+  frame.usePattern(_firstLED, _lastLED);
+  frame.show();
+  _lastUpdateTime = animationMillis();
 }
 
 // keep the animation going until completed
@@ -84,7 +93,7 @@ void ColorSwirl::Continue() {
   if (!_active) {                           // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {  // appropriate time elapsed?
     return;                                 // not yet
@@ -94,21 +103,23 @@ void ColorSwirl::Continue() {
     _swirlIdx = 254;
     _swirlInc = -_swirlInc;
   }
-  for (int i=_firstLED; i<=_lastLED; i++) {
-    int rc_index = (i*256/(_lastLED-_firstLED)) + _swirlIdx;
-    pixels.setPixelColor(i, wheel(rc_index & 255));
-  }
-  pixels.show();
+  frame.pattern().setPhase(_swirlPhase + long(_swirlIdx & 255)*swirlPeriod);  // one wheel step
+  frame.show();
   _lastUpdateTime = now;                  // "schedule" next update
 }
 
 // start the shutdown of the animation; in this case it's just running it again but with color=black
 void ColorSwirl::Finish(bool topToBottom) {
   _topToBottom = topToBottom;               // unused, compiler bliss
+  frame.clearPattern();
   setAllPixelsTo(offColor);
   _active = false;
 }
 
+bool ColorSwirl::Deterministic() {
+  return true;                              // (SingleSwirl too)
+}
+
 void ColorSwirl::printSelf() {
   Serial.print("Color swirl "); Serial.println(_animationStepIncrement);
 }
@@ -127,10 +138,10 @@ void SingleSwirl::Start(bool topToBottom, uint32_t colorToUse) {
   _active = true;
   _swirlIdx = 0;
   _swirlInc = 1;
-  pixels.setBrightness(255);
+  frame.setBrightness(255);
   setAllPixelsTo(_swirlIdx);
-  pixels.show();
-  _lastUpdateTime = millis();
+  frame.show();
+  _lastUpdateTime = animationMillis();
 }
 
 // keep the animation going until completed
@@ -138,7 +149,7 @@ void SingleSwirl::Continue() {
   if (!_active) {                           // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {  // appropriate time elapsed?
     return;                                 // not yet
@@ -173,10 +184,6 @@ Marquee::Marquee(const char * animationName, float animationTime, int firstOffse
     _animationStepIncrement = 150;
   }
   marqueeQuanta = 7;
-  int tenPercent = round((_lastLED - _firstLED)/10.0);
-  if (marqueeQuanta >  tenPercent) {
-    marqueeQuanta = tenPercent+1;
-  }
 }
 
 void Marquee::Start(bool topToBottom, uint32_t colorToUse) {
@@ -187,50 +194,52 @@ void Marquee::Start(bool topToBottom, uint32_t colorToUse) {
   if (topToBottom) {
     _marqueeInc = -1;
   }
-  _marqueeOffset = 0;
-  pixels.setBrightness(mappedBrightness());
-  setAllPixelsTo(_colorToUse);
-  Continue();
+  int quanta = marqueeQuanta;                 // no more than a tenth of this segment
+  int tenPercent = round((_lastLED - _firstLED)/10.0);
+  if (quanta > tenPercent) {
+    quanta = tenPercent+1;
+  }
+  frame.setBrightness(mappedBrightness());
+  PeriodicPattern &lights = frame.pattern(); // one OFF LED then quanta-1 ON LEDs
+  lights.setPeriod(quanta);
+  lights.setEntry(0, offColor);
+  for (int i=1; i<quanta; i++) {
+    lights.setEntry(i, _colorToUse);
+  }
+  frame.usePattern(_firstLED, _lastLED);
+  frame.show();
+  _lastUpdateTime = animationMillis();
 }
 
-// keep the animation going until completed
+// keep the animation going until completed; moving the lights is just a phase change
 void Marquee::Continue() {
   if (!_active) {                           // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {  // appropriate time elapsed?
     return;                                 // not yet
   }
-// turn on LEDs that were OFF
-  for (int i=_firstLED+_marqueeOffset; i<=_lastLED; i = i + marqueeQuanta) {
-    pixels.setPixelColor(i, _colorToUse);
-  }
-  _marqueeOffset += _marqueeInc;
-  if (_marqueeOffset < 0) {
-    _marqueeOffset = marqueeQuanta-1;
-  }
-  if (_marqueeOffset >= marqueeQuanta) {
-    _marqueeOffset = 0;
-  }
-// turn OFF next set of LEDs
-  for (int i=_firstLED+_marqueeOffset; i<=_lastLED; i = i + marqueeQuanta) {
-    pixels.setPixelColor(i, offColor);
-  }
-  pixels.show();
+  frame.pattern().advance(-256L*_marqueeInc);  // OFF LED moves _marqueeInc pixels
+  frame.show();
   _lastUpdateTime = now;                   // "schedule" next update
 }
 
 // start the shutdown of the animation; in this case it's just running it again but with color=black
 void Marquee::Finish(bool topToBottom) {
   _topToBottom = topToBottom;              // unused, compiler bliss
+  frame.clearPattern();
   setAllPixelsTo(offColor);
-  pixels.setBrightness(255);
-  pixels.show();
+  frame.setBrightness(255);
+  frame.show();
   _active = false;
 }
 
+bool Marquee::Deterministic() {
+  return true;
+}
+
 void Marquee::printSelf() {
   Serial.print("Marquee "); Serial.println(_animationStepIncrement);
 }
@@ -12,6 +12,9 @@
  * The ColorSwirl code was translated from an Aadfruit CircuitPython example
  * minor modifications made to support the Start, Continue, Finish implementation
  * model
+ * 
+ * ColorSwirl and Marquee draw with the frame's periodic pattern, so each
+ * step moves the pattern rather than rewriting every pixel.
  * 
   * @section author Author
  * 
@@ -49,11 +52,13 @@ class ColorSwirl : public Animation {
     void Start(bool topToBottom, uint32_t colorToUse);
     void Continue();
     void Finish(bool topToBottom);
+    bool Deterministic();
     bool Active();
     void printSelf();
   protected:
     int _swirlIdx;
     int _swirlInc;
+    long _swirlPhase;               // pattern phase for _swirlIdx==0
 
     uint32_t wheel(int pos);
 };
@@ -81,13 +86,13 @@ class Marquee : public Animation {
     void Start(bool topToBottom, uint32_t colorToUse);
     void Continue();
     void Finish(bool topToBottom);
+    bool Deterministic();
     bool Active();
     void printSelf();
  
     int marqueeQuanta;             // # of ON LEDs between OFF LEDs
  
   private:
-    int _marqueeOffset;
     int _marqueeInc;
 };
 
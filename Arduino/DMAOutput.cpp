@@ -0,0 +1,238 @@
+/*!
+ * @file DMAOutput.cpp
+ *
+ * @mainpage Arduino library for non-blocking WS2812 output using SPI and DMA
+ *
+ * @section intro_sec Introduction
+ *
+ * Encodes a PaletteFrame into WS2812 SPI bitstreams and sends them with
+ * DMA on SAMD21/SAMD51 boards. Elsewhere the transfer is emulated.
+ *
+ * @section dependencies Dependencies
+ *
+ * With kDMAOutput 1 on SAMD boards this file depends on the SPI and
+ * Adafruit_ZeroDMA libraries.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * DMAOutput.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "DMAOutput.h"
+#include "PaletteFrame.h"
+
+#define encodeChunk 16                // pixels expanded from the frame at a time
+
+/************************************************************************************
+ * SAMD: the SERCOM behind the SPI pins, and the DMA trigger for it. These match the
+ * SPI pins of a Trinket M0 (SERCOM0) and a Feather/ItsyBitsy M4 (SERCOM1); define
+ * them before including this file for other boards.
+ ************************************************************************************/
+#if kDMAHardware
+#include <SPI.h>
+#include <Adafruit_ZeroDMA.h>
+
+#ifndef kDMASercom
+#if defined(__SAMD51__)
+#define kDMASercom SERCOM1
+#define kDMATrigger SERCOM1_DMAC_ID_TX
+#else
+#define kDMASercom SERCOM0
+#define kDMATrigger SERCOM0_DMAC_ID_TX
+#endif
+#endif
+
+static Adafruit_ZeroDMA stripDMA;
+static DmacDescriptor *stripDescriptor;
+static DMAOutput *stripDMAOutput;     // there's one SPI SERCOM, so one output
+
+static void dmaCallback(Adafruit_ZeroDMA *dma) {
+  (void)dma;
+  stripDMAOutput->transferDone();
+}
+#endif
+
+static void widenRange(int &first, int &last, int otherFirst, int otherLast) {
+  if (otherFirst > otherLast) {
+    return;
+  }
+  if (first > last) {
+    first = otherFirst;
+    last = otherLast;
+    return;
+  }
+  first = min(first, otherFirst);
+  last = max(last, otherLast);
+}
+
+DMAOutput::DMAOutput() {
+  _length = 0;
+  _sending = 0;
+  _queued = -1;
+  _busy = false;
+  _framesSent = 0;
+  _framesReplaced = 0;
+  _encodeMicros = 0;
+  for (int b=0; b<2; b++) {
+    _lacksFirst[b] = 0;                 // neither has anything yet
+    _lacksLast[b] = kNumberOfLEDs-1;
+  }
+#if !kDMAHardware
+  _busyUntil = 0;
+#endif
+}
+
+// set up SPI & DMA; the trailing reset (LOW) bytes never change so they're done here
+void DMAOutput::begin() {
+  _length = kBitstreamBytes;
+  memset(_bitstream, 0, sizeof(_bitstream));
+#if kDMAHardware
+  stripDMAOutput = this;
+  SPI.begin();
+  SPI.beginTransaction(SPISettings(kWS2812SPIClock, MSBFIRST, SPI_MODE0));
+  stripDMA.setTrigger(kDMATrigger);
+  stripDMA.setAction(DMA_TRIGGER_ACTON_BEAT);
+  stripDMA.allocate();
+  stripDescriptor = stripDMA.addDescriptor(_bitstream[0], (void *)(&kDMASercom->SPI.DATA.reg), _length,
+                                           DMA_BEAT_SIZE_BYTE, true, false);
+  stripDMA.setCallback(dmaCallback);
+#endif
+}
+
+bool DMAOutput::ready() {
+#if !kDMAHardware
+  emulate();
+#endif
+  return !_busy && (_queued < 0);
+}
+
+/************************************************************************************
+ * each data bit becomes 110 (one) or 100 (zero), most significant bit first, so a
+ * nibble becomes 12 bits and a byte 3 bytes of bitstream. The table is small
+ * enough to stay in cache on bigger processors; a 256 entry one isn't faster on
+ * the M0 (no cache) and costs 768 bytes more flash.
+ ************************************************************************************/
+static const uint16_t nibbleSymbols[16] = {
+  0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+  0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+void encodeWS2812(const uint8_t *bytes, int count, uint8_t *bitstream) {
+  for (int i=0; i<count; i++) {
+    uint8_t aByte = bytes[i];
+    uint32_t symbols = (uint32_t(nibbleSymbols[aByte >> 4]) << 12) | nibbleSymbols[aByte & 0x0F];
+    bitstream[0] = symbols >> 16;
+    bitstream[1] = symbols >> 8;
+    bitstream[2] = symbols;
+    bitstream += 3;
+  }
+}
+
+// expand a chunk at a time (GRB, as the strip wants it) and encode it; the rest
+// of the bitstream still holds what it had
+void DMAOutput::encode(FrameSource &aFrame, int first, int last, uint8_t *bitstream) {
+  uint8_t grb[encodeChunk*3];
+  uint8_t *out = bitstream + first*3*kWS2812BitsPerBit;
+  for (int chunk=first; chunk<=last; chunk+=encodeChunk) {
+    int count = min(encodeChunk, last+1-chunk);
+    aFrame.expand(chunk, count, grb);
+    encodeWS2812(grb, count*3, out);
+    out += count*3*kWS2812BitsPerBit;
+  }
+}
+
+// with interrupts off, or from the DMA interrupt
+void DMAOutput::startTransfer(int buffer) {
+  _sending = buffer;
+  _busy = true;
+  _framesSent += 1;
+#if kDMAHardware
+  stripDMA.changeDescriptor(stripDescriptor, _bitstream[buffer]);
+  stripDMA.startJob();
+#else
+  _busyUntil = micros() + (unsigned long)(_length * 8 * 1000000ULL / kWS2812SPIClock);
+#endif
+}
+
+void DMAOutput::transferDone() {
+  _busy = false;
+  if (_queued >= 0) {
+    int buffer = _queued;
+    _queued = -1;
+    startTransfer(buffer);
+  }
+}
+
+#if !kDMAHardware
+// the emulated transfer ends when the clock says so, and what's queued starts then
+void DMAOutput::emulate() {
+  if (_busy && (long(micros() - _busyUntil) >= 0)) {
+    unsigned long ended = _busyUntil;
+    transferDone();
+    if (_busy) {
+      _busyUntil = ended + (unsigned long)(_length * 8 * 1000000ULL / kWS2812SPIClock);
+    }
+  }
+}
+#endif
+
+// the bitstream not being sent gets the frame (a queued one is taken back and
+// replaced); it goes now if the strip's free, else when the interrupt says so
+void DMAOutput::show(FrameSource &aFrame) {
+  int dirtyFirst, dirtyLast;
+  if (!aFrame.dirtyRange(dirtyFirst, dirtyLast) || (dirtyFirst >= kNumberOfLEDs)) {
+    return;                                 // the strip is already showing this frame
+  }
+  dirtyLast = min(dirtyLast, kNumberOfLEDs-1);
+#if !kDMAHardware
+  emulate();
+#endif
+  noInterrupts();
+  if (_queued >= 0) {
+    _queued = -1;
+    _framesReplaced += 1;
+  }
+  int idle = 1 - _sending;
+  interrupts();
+  for (int b=0; b<2; b++) {
+    widenRange(_lacksFirst[b], _lacksLast[b], dirtyFirst, dirtyLast);
+  }
+  unsigned long encodeStart = micros();
+  encode(aFrame, _lacksFirst[idle], _lacksLast[idle], _bitstream[idle]);
+  _encodeMicros += micros() - encodeStart;
+  _lacksFirst[idle] = 1;
+  _lacksLast[idle] = 0;
+#if !kDMAHardware
+  emulate();
+#endif
+  noInterrupts();
+  if (_busy) {
+    _queued = idle;
+  } else {
+    startTransfer(idle);
+  }
+  interrupts();
+}
+
+void DMAOutput::printStats() {
+  Serial.print("DMAOutput frames: "); Serial.print(_framesSent);
+  Serial.print(" replaced: "); Serial.print(_framesReplaced);
+  Serial.print(" encoding us: "); Serial.println(_encodeMicros);
+}
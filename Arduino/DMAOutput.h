@@ -0,0 +1,109 @@
+/*!
+ * @file DMAOutput.h
+ *
+ * @mainpage Arduino library for non-blocking WS2812 output using SPI and DMA
+ *
+ * @section intro_sec Introduction
+ *
+ * Adafruit_NeoPixel::show() bit-bangs the strip with interrupts off, so
+ * the processor can do nothing else until the last LED has its data.
+ * DMAOutput instead encodes the frame into a WS2812 bitstream (3 SPI
+ * bits per data bit at 2.4 MHz) and lets the DMA controller feed it to
+ * the SPI MOSI pin. show() never waits for the strip.
+ *
+ * There are two bitstreams. While one is being sent, show() encodes the
+ * next frame into the other and queues it; the DMA interrupt starts it as
+ * soon as the first is done. A frame shown while another is still queued
+ * replaces it (the strip can't take frames any faster). Each bitstream
+ * only has re-encoded what changed since it last went out; an unchanged
+ * frame isn't sent again.
+ *
+ * The strip's data line must be on the SPI MOSI pin, and SPI.begin()
+ * also takes the SCK and MISO pins. On a Trinket M0 those are D4, D3
+ * and D2, which stairway.ino uses for its sensors; it won't build with
+ * useDMAOutput until they're moved. The bitstreams need 18 bytes per LED.
+ *
+ * Set kDMAOutput to 1 to use it on a SAMD board (it then needs the
+ * Adafruit_ZeroDMA library). Otherwise, and on a host computer, the
+ * transfer is emulated by marking the output busy for as long as the
+ * real transfer would take, so the pipelining can be measured.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * DMAOutput.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "AnimationGlobals.h"
+#include "StripOutput.h"
+
+#ifndef DMAOutput_h
+#define DMAOutput_h
+
+#ifndef kDMAOutput
+#define kDMAOutput 0                                // 1 -> send with SPI & DMA (stairway.ino's useDMAOutput)
+#endif
+#if defined(ARDUINO_ARCH_SAMD) && kDMAOutput
+#define kDMAHardware 1
+#else
+#define kDMAHardware 0                              // transfers are emulated
+#endif
+
+#define kWS2812BitsPerBit 3                         // SPI bits sent per WS2812 data bit
+#define kWS2812SPIClock 2400000                     // SPI clock for 3 bits per 1.25us
+#define kResetBytes 90                              // >280us of LOW latches the data
+#define kBitstreamBytes (kNumberOfLEDs*3*kWS2812BitsPerBit + kResetBytes)
+
+// count bytes, in the order they go down the wire (GRB for NEO_GRB strips), to
+// 3*count bytes of SPI bitstream; table driven, no per bit work
+void encodeWS2812(const uint8_t *bytes, int count, uint8_t *bitstream);
+
+/************************************************************************************
+ * begin() once, then show(frame) whenever a frame is ready
+ ************************************************************************************/
+class DMAOutput : public StripOutput {
+  public:
+    DMAOutput();
+    void begin();
+    void show(FrameSource &aFrame);        // encode into the idle bitstream & queue it; never waits
+    bool ready();                           // nothing being sent or queued?
+    const char *name() { return "DMA"; }
+    void printStats();                      // frames sent & replaced, time encoding
+    void transferDone();                    // from the DMA interrupt: start what's queued
+
+  private:
+    uint8_t _bitstream[2][kBitstreamBytes]; // one being (or last) sent, one for the next frame
+    int _lacksFirst[2];                     // LEDs each bitstream hasn't had encoded since the
+    int _lacksLast[2];                      // frame changed (first > last: none)
+    volatile uint8_t _sending;              // bitstream being (or last) sent
+    volatile int8_t _queued;                // bitstream waiting to go, -1 if none
+    volatile bool _busy;                    // a transfer is going
+    int _length;                            // bytes of each bitstream in use
+    unsigned long _framesSent;
+    unsigned long _framesReplaced;          // queued but replaced by a newer frame before going
+    unsigned long _encodeMicros;            // total time spent encoding
+
+    void encode(FrameSource &aFrame, int first, int last, uint8_t *bitstream);
+    void startTransfer(int buffer);
+#if !kDMAHardware
+    unsigned long _busyUntil;               // micros() when the emulated transfer ends
+    void emulate();                         // finish the emulated transfer if it's time
+#endif
+};
+
+#endif
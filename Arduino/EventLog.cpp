@@ -0,0 +1,102 @@
+/*!
+ * @file EventLog.cpp
+ *
+ * @mainpage Arduino library for cheap binary event logging
+ *
+ * @section intro_sec Introduction
+ *
+ * The ring buffer and the binary framing; see EventLog.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * EventLog.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "EventLog.h"
+
+static_assert((kLogRecords & (kLogRecords - 1)) == 0, "kLogRecords must be a power of 2");
+
+EventLog eventLog;
+
+EventLog::EventLog() {
+  _head = 0;
+  _tail = 0;
+  _droppedSinceDrain = 0;
+  _dropped = 0;
+}
+
+// the record is filled in before _head moves past it, so drain() never sees half
+// a record
+void EventLog::add(LogEvent event, int16_t a, int32_t b) {
+  uint16_t head = _head;
+  uint16_t next = (head + 1) & (kLogRecords - 1);
+  if (next == _tail) {                    // full
+    _droppedSinceDrain += 1;
+    _dropped += 1;
+    return;
+  }
+  LogRecord &aRecord = _records[head];
+  aRecord.time = micros();
+  aRecord.event = event;
+  aRecord.a = a;
+  aRecord.b = b;
+  __sync_synchronize();                   // record complete before it's published
+  _head = next;
+}
+
+bool EventLog::empty() {
+  return _head == _tail;
+}
+
+unsigned long EventLog::dropped() {
+  return _dropped;
+}
+
+void EventLog::writeFrame(Print &out, const LogRecord &aRecord) {
+  uint8_t frame[kLogFrameBytes];
+  uint32_t values[3] = { aRecord.time, uint32_t(aRecord.event) | (uint32_t(uint16_t(aRecord.a)) << 16),
+                         uint32_t(aRecord.b) };
+  uint8_t check = 0;
+  frame[0] = kLogFrameSync;
+  for (int i=0; i<kLogRecordBytes; i++) { // little endian whatever the processor
+    uint8_t aByte = values[i / 4] >> (8 * (i % 4));
+    frame[1 + i] = aByte;
+    check ^= aByte;
+  }
+  frame[kLogFrameBytes - 1] = check;
+  out.write(frame, kLogFrameBytes);
+}
+
+int EventLog::drain(Print &out) {
+  int sent = 0;
+  if ((_droppedSinceDrain != 0) && (out.availableForWrite() >= kLogFrameBytes)) {
+    LogRecord lost = { uint32_t(micros()), evLogDropped, 0, _droppedSinceDrain };
+    _droppedSinceDrain = 0;
+    writeFrame(out, lost);
+    sent += 1;
+  }
+  while ((_tail != _head) && (sent < kLogDrainRecords) && (out.availableForWrite() >= kLogFrameBytes)) {
+    uint16_t tail = _tail;
+    writeFrame(out, _records[tail]);
+    __sync_synchronize();                 // finished with the record before freeing it
+    _tail = (tail + 1) & (kLogRecords - 1);
+    sent += 1;
+  }
+  return sent;
+}
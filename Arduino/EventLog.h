@@ -0,0 +1,108 @@
+/*!
+ * @file EventLog.h
+ *
+ * @mainpage Arduino library for cheap binary event logging
+ *
+ * @section intro_sec Introduction
+ *
+ * Serial.print() formats text and waits for it to go out, which is slow
+ * enough to change the timing being debugged. LOG_EVENT(event, a, b)
+ * instead copies a 12 byte record (time in micros, event id, two
+ * arguments) into a ring buffer; that's all it costs. drain() sends at
+ * most kLogDrainRecords records (56 bytes) to Serial, in binary, each
+ * time loop() calls it. availableForWrite() is checked too, but the
+ * SAMD's USB Serial returns a constant from it rather than the space in
+ * its buffer, so the cap is what keeps a burst of records from holding
+ * up loop(). Turning the records back into text is done on the host by
+ * host/decodeLog.py, using the event list in LogEvents.h.
+ *
+ * On the wire each record is a frame: 0xA5, the 12 record bytes (little
+ * endian) and an XOR check byte. Anything else on the Serial line (the
+ * start up text, say) is passed through by the decoder.
+ *
+ * The ring has one writer (code running from loop(), not interrupts)
+ * and one reader (drain()), so it needs no locking. When it's full new
+ * records are dropped and counted; the count goes out as an
+ * evLogDropped record once there's room.
+ *
+ * Set kEventLogging to 0 to compile all logging out.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * EventLog.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef EventLog_h
+#define EventLog_h
+
+#ifndef kEventLogging
+#define kEventLogging 1                   // 0 -> LOG_EVENT() does nothing
+#endif
+#define kLogRecords 64                    // ring size, must be a power of 2
+#define kLogDrainRecords 4                // most records drain() sends per call
+#define kLogFrameSync 0xA5
+#define kLogRecordBytes 12
+#define kLogFrameBytes (kLogRecordBytes + 2)
+
+// event ids, in LogEvents.h order
+#define LOG_EVENT_ENTRY(name, text) name,
+enum LogEvent {
+#include "LogEvents.h"
+  evLogEventCount
+};
+#undef LOG_EVENT_ENTRY
+
+struct LogRecord {
+  uint32_t time;                          // micros()
+  uint16_t event;
+  int16_t a;
+  int32_t b;
+};
+
+/************************************************************************************
+ * one global instance, eventLog; use it through LOG_EVENT()
+ ************************************************************************************/
+class EventLog {
+  public:
+    EventLog();
+    void add(LogEvent event, int16_t a, int32_t b);
+    int drain(Print &out);                // send a few; returns # sent
+    bool empty();
+    unsigned long dropped();              // total records lost to a full ring
+
+  private:
+    LogRecord _records[kLogRecords];
+    volatile uint16_t _head;              // next to write, only add() changes it
+    volatile uint16_t _tail;              // next to send, only drain() changes it
+    volatile uint16_t _droppedSinceDrain; // not yet reported
+    unsigned long _dropped;
+
+    void writeFrame(Print &out, const LogRecord &aRecord);
+};
+
+extern EventLog eventLog;
+
+#if kEventLogging
+#define LOG_EVENT(event, a, b) eventLog.add((event), (a), (b))
+#else
+#define LOG_EVENT(event, a, b) do { } while (0)
+#endif
+
+#endif
@@ -10,7 +10,8 @@
  * the pixels on a NeoPixel strip. 
  * 
  * FadeToColor lights all LEDs with a specified color, but uses brightness
- * control to fade in, and then out.
+ * control to fade in, and then out. The brightness comes from a Fader, so
+ * it depends on elapsed time rather than on how many steps were shown.
  * 
  * @section author Author
  * 
@@ -36,13 +37,18 @@
 #include <Adafruit_NeoPixel.h>
 #include "FadeAndWipe.h"
 #include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+#include "StairGeometry.h"
+
+#define fadeFrameInterval 16          // ms between fade frames (~60 per second)
 
 
 /************************************************************************************
  * Gradually fades from BLACK to some color
  ************************************************************************************/
 FadeToColor::FadeToColor(const char * animationName, float animationTime, int firstOffset, int lastOffset):Animation(animationName, animationTime, firstOffset, lastOffset) {
-  _animationStepIncrement = int(round(_animationTime*1000/255));  // different interval computation here
+  _animationStepIncrement = fadeFrameInterval;  // different interval computation here
+  fadeEasing = fadeSine;
 }
 
 // start up the animation
@@ -51,8 +57,9 @@ void FadeToColor::Start(bool topToBottom, uint32_t colorToUse) {
   _colorToUse = colorToUse;
   _active = true;
   _lastUpdateTime = 0;
-  _fadeBrightness = 0;
-  _fadeBrightnessInc = 1;
+  _fadingOut = false;
+  _fader.start(0, 65535, int(round(_animationTime*1000)), fadeEasing, animationMillis());
+  frame.setBrightnessLevel(0);
   setAllPixelsTo(_colorToUse, false);           // set LEDs to specified color
   Continue();                                   // do first increment right now
 }
@@ -62,38 +69,40 @@ void FadeToColor::Continue() {
   if (!_active) {                               // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {      // appropriate time elapsed?
     return;                                     // not yet
   }
-  pixels.setBrightness(_fadeBrightness);        // set the brightness
+  frame.setBrightnessLevel(_fader.level(now));  // brightness for this moment in the fade
   setAllPixelsTo(_colorToUse, false);           // make sure all pixels still correct color
-  pixels.show();
-  _fadeBrightness += _fadeBrightnessInc;        // step the brightness
-  if ((_fadeBrightness > 255) || (_fadeBrightness <= 0)) {
-    _active = false;                            // if done, mark that way
-  }
-  if (!_active) {                               // if just fell out of active
-    if (_fadeBrightness <= 0) {                 // and were headed toward off
+  frame.show();
+  if (_fader.done(now)) {                       // if done, mark that way
+    _active = false;
+    if (_fadingOut) {                           // and were headed toward off
       _colorToUse = offColor;                   // make the final color black
     }
-    setAllPixelsTo(_colorToUse);                // finalize the color
-    pixels.setBrightness(255);                  // and return to a good brightness
-    pixels.show();
+    setAllPixelsTo(_colorToUse, false);         // finalize the color
+    frame.setBrightness(255);                   // and return to a good brightness
+    frame.show();
   }
   _lastUpdateTime = now;                        // "schedule" next update
 }
 
-// start the shutdown of the animation; in this case it's just running it again but with color=black
+// start the shutdown of the animation; fade out from wherever the fade in got to
 void FadeToColor::Finish(bool topToBottom) {
   _topToBottom = topToBottom;                   // unused, keep compiler happy
-  _fadeBrightness = 255;                        // you'd think we should switch to offColor, but need original for fade out
-  _fadeBrightnessInc = -1;
+  _fadingOut = true;                            // you'd think we should switch to offColor, but need original for fade out
+  _fader.start(frame.getBrightnessLevel(), 0, int(round(_animationTime*1000)), fadeEasing, animationMillis());
+  _lastUpdateTime = 0;
   _active = true;                               // active again
   Continue();
 }
 
+bool FadeToColor::Deterministic() {
+  return true;                                  // the fader only needs the time
+}
+
 void FadeToColor::printSelf() {
   Serial.print("FadeToColor "); Serial.println(_animationStepIncrement);
 }
@@ -103,6 +112,9 @@ void FadeToColor::printSelf() {
  * Light LED strip one LED at a time from top to bottom or vice versa
  ************************************************************************************/
 ColorWipe::ColorWipe(const char * animationName, float animationTime, int firstOffset, int lastOffset):Animation(animationName, animationTime, firstOffset, lastOffset) {
+  dimPassedSteps = false;
+  _paced = false;
+  _dimming = false;
 }
 
 // start up the animation
@@ -110,16 +122,27 @@ void ColorWipe::Start(bool topToBottom, uint32_t colorToUse) {
   _topToBottom = topToBottom;
   _colorToUse = colorToUse;
   _active = true;
+  frame.setBrightness(255);                    // make sure brightness set
+  _steps = geometry.stepsWithin(_firstLED, _lastLED, _firstStep);
+  _paced = (colorToUse != offColor) && (_steps > 0);
+  if (_paced) {                                 // someone's coming; keep ahead of them
+    _dimming = dimPassedSteps;
+    _stepsWalked = 0;
+    _stepsLit = 0;
+    _stepsDimmed = 0;
+    _stepDone = animationMillis() + stepAt(0).strides * geometry.strideTime();
+    continuePaced(animationMillis());
+    return;
+  }
   _wipeLEDIdx = _firstLED;                      // decide which end of the strip to start from
   _wipeInc = 1;
   if (_topToBottom) {
     _wipeLEDIdx = _lastLED;
     _wipeInc = -1;
   }
-  pixels.setBrightness(255);                    // make sure brightness set
-  _lastUpdateTime = millis();                   // we've done the first step here
-  pixels.setPixelColor(_wipeLEDIdx, _colorToUse);
-  pixels.show();
+  _lastUpdateTime = animationMillis();          // we've done the first step here
+  frame.setPixelColor(_wipeLEDIdx, _colorToUse);
+  frame.show();
 }
 
 // keep the animation going until completed
@@ -127,7 +150,11 @@ void ColorWipe::Continue() {
   if (!_active) {                               // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();
+  unsigned long now = animationMillis();
+  if (_paced) {
+    continuePaced(now);
+    return;
+  }
   int elapsed = (now - _lastUpdateTime);
   if (elapsed < _animationStepIncrement) {      // appropriate time elapsed?
     return;                                     // not yet
@@ -137,16 +164,79 @@ void ColorWipe::Continue() {
     _active = false;                            // animation compelete?
     return;
   }
-  pixels.setPixelColor(_wipeLEDIdx, _colorToUse); // do next LED
-  pixels.show();
+  frame.setPixelColor(_wipeLEDIdx, _colorToUse); // do next LED
+  frame.show();
   _lastUpdateTime = now;                        // "schedule" next update
 }
 
+/************************************************************************************
+ * move the walker on by the steps they've had time to cross, light the ones ahead
+ * of them and dim the ones well behind. Done when they're off the last step.
+ ************************************************************************************/
+void ColorWipe::continuePaced(unsigned long now) {
+  while ((_stepsWalked < _steps) && (long(now - _stepDone) >= 0)) {
+    _stepsWalked += 1;
+    if (_stepsWalked < _steps) {
+      _stepDone += stepAt(_stepsWalked).strides * geometry.strideTime();
+    }
+  }
+  bool changed = false;
+  int lit = min(_stepsWalked + 1 + kStepsAhead, _steps);
+  while (_stepsLit < lit) {
+    fillStep(_stepsLit++, _colorToUse);
+    changed = true;
+  }
+  if (_dimming) {
+    uint32_t dimColor = rgbColor(((_colorToUse >> 16) & 0xFF) * kPassedLevel / 255,
+                                 ((_colorToUse >> 8) & 0xFF) * kPassedLevel / 255,
+                                 (_colorToUse & 0xFF) * kPassedLevel / 255);
+    while (_stepsDimmed < _stepsWalked - kStepsBehind) {
+      fillStep(_stepsDimmed++, dimColor);
+      changed = true;
+    }
+  }
+  if (changed) {
+    frame.show();
+  }
+  if (_stepsWalked >= _steps) {
+    _active = false;
+  }
+}
+
+const StairStep &ColorWipe::stepAt(int n) {
+  return geometry.step(_firstStep + (_topToBottom ? _steps-1-n : n));
+}
+
+void ColorWipe::fillStep(int n, uint32_t aColor) {
+  const StairStep &aStep = stepAt(n);
+  frame.fill(aColor, aStep.firstLED, aStep.lastLED - aStep.firstLED + 1);
+}
+
+// someone else on the stairs: light all of it, and leave it lit
+void ColorWipe::Joined(bool fromTop) {
+  (void)fromTop;
+  if (!_paced) {
+    return;
+  }
+  for (int n=0; n<_steps; n++) {
+    fillStep(n, _colorToUse);
+  }
+  frame.show();
+  _stepsLit = _steps;
+  _stepsDimmed = 0;
+  _dimming = false;
+}
+
 // start the shutdown of the animation; in this case it's just running it again but with color=black
 void ColorWipe::Finish(bool topToBottom) {
   Start(topToBottom, offColor);                 // done exactly the same so re-use Start
 }
 
+bool ColorWipe::Deterministic() {
+  return true;                                  // geometry's pace only changes as someone leaves
+}
+
 void ColorWipe::printSelf() {
-  Serial.print("ColorWipe "); Serial.println(_animationStepIncrement);
+  Serial.print("ColorWipe "); Serial.print(_animationStepIncrement);
+  Serial.print(" stride ms: "); Serial.println(geometry.strideTime());
 }
@@ -7,10 +7,14 @@
 * @section intro_sec Introduction
  * 
  * The ColorWipe class is derived from Animation and incrementally lights 
- * the pixels on a NeoPixel strip. 
+ * the pixels on a NeoPixel strip. Lighting up, it goes a step at a time
+ * (see StairGeometry.h) at the pace people have been walking the stairs,
+ * keeping a couple of steps ahead of the walker, and can dim the steps
+ * they've left behind.
  * 
  * FadeToColor lights all LEDs with a specified color, but uses brightness
- * control to fade in, and then out.
+ * control to fade in, and then out. The brightness comes from a Fader, so
+ * it depends on elapsed time rather than on how many steps were shown.
  * 
  * @section author Author
  * 
@@ -35,10 +39,13 @@
 #include "Arduino.h"
 #include <Adafruit_NeoPixel.h>
 #include "Animation.h"
+#include "Fader.h"
+#include "StairGeometry.h"
 
 #ifndef FadeAndWipe_h
 #define FadeAndWipe_h
 
+#define kFadeToColorTime 1.3              // seconds the sketch's fade in (and out) takes
 
 /************************************************************************************
  * Gradually fades from BLACK to some color
@@ -49,19 +56,25 @@ class FadeToColor : public Animation {
     void Start(bool topToBottom, uint32_t colorToUse);
     void Continue();
     void Finish(bool topToBottom);
+    bool Deterministic();
     bool Active();
     void printSelf();
   
+    int fadeEasing;                 // fadeLinear, fadeQuadratic or fadeSine (see Fader.h)
+
   private:
-    int _wipeLEDIdx;
-    int _wipeInc;
-    int _fadeBrightness;
-    int _fadeBrightnessInc;
+    Fader _fader;
+    bool _fadingOut;
 };
 
 
+#define kStepsAhead 2                     // lit ahead of the step the walker is on
+#define kStepsBehind 1                    // left at full brightness behind them
+#define kPassedLevel 40                   // dimmed steps, out of 255
+
 /************************************************************************************
- * Light LED strip one LED at a time from top to bottom or vice versa
+ * Light LED strip one LED at a time from top to bottom or vice versa; lighting up
+ * with steps known, a step at a time just ahead of the walker
  ************************************************************************************/
 class ColorWipe : public Animation {
   public:
@@ -69,12 +82,28 @@ class ColorWipe : public Animation {
     void Start(bool topToBottom, uint32_t colorToUse);
     void Continue();
     void Finish(bool topToBottom);
+    bool Deterministic();
+    void Joined(bool fromTop);
     bool Active();
     void printSelf();
 
+    bool dimPassedSteps;                  // dim steps the walker has left behind
+
   private:
     int _wipeLEDIdx;
     int _wipeInc;
+    bool _paced;                          // lighting by steps rather than LEDs
+    bool _dimming;                        // dimPassedSteps, until someone else turns up
+    int _firstStep;                       // the steps between _firstLED & _lastLED
+    int _steps;
+    int _stepsWalked;                     // steps the walker has crossed,
+    unsigned long _stepDone;              // and when they'll be off the next one
+    int _stepsLit;                        // counted from the end they started at
+    int _stepsDimmed;
+
+    void continuePaced(unsigned long now);
+    const StairStep &stepAt(int n);       // n counted from the starting end
+    void fillStep(int n, uint32_t aColor);
 };
 
 #endif
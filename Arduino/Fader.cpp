@@ -0,0 +1,94 @@
+/*!
+ * @file Fader.cpp
+ *
+ * @mainpage Arduino library for time based brightness fades
+ *
+ * @section intro_sec Introduction
+ *
+ * Computes a brightness level as a function of elapsed time, with a
+ * choice of easing curves. Integer math only.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Fader.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "Fader.h"
+
+/************************************************************************************
+ * (1-cos(pi*t))/2 sampled at 33 points, 0..65535; ease() interpolates between them
+ ************************************************************************************/
+static const uint16_t sineEase[33] = {
+      0,   158,   630,  1411,  2494,  3869,  5522,  7438,
+   9597, 11980, 14563, 17321, 20228, 23256, 26375, 29556,
+  32767, 35979, 39160, 42279, 45307, 48214, 50972, 53555,
+  55938, 58097, 60013, 61666, 63041, 64124, 64905, 65377,
+  65535
+};
+
+Fader::Fader() {
+  _from = 0;
+  _to = 0;
+  _startTime = 0;
+  _duration = 0;
+  _easing = fadeLinear;
+}
+
+void Fader::start(uint16_t fromLevel, uint16_t toLevel, unsigned long duration, int easing, unsigned long now) {
+  _from = fromLevel;
+  _to = toLevel;
+  _duration = duration;
+  _easing = easing;
+  _startTime = now;
+}
+
+uint16_t Fader::ease(uint16_t t) {
+  switch (_easing) {
+    case fadeQuadratic:
+      if (t < 32768) {                    // 2t^2
+        return uint16_t((uint32_t(t) * t) >> 15);
+      } else {                            // 1 - 2(1-t)^2
+        uint32_t r = 65535 - t;
+        return 65535 - uint16_t((r * r) >> 15);
+      }
+    case fadeSine: {
+      int idx = t >> 11;                  // 32 segments
+      uint32_t fraction = t & 0x7FF;
+      uint32_t a = sineEase[idx];
+      uint32_t b = sineEase[idx+1];
+      return uint16_t(a + (((b - a) * fraction) >> 11));
+    }
+    default:
+      return t;
+  }
+}
+
+uint16_t Fader::level(unsigned long now) {
+  unsigned long elapsed = now - _startTime;
+  if ((_duration == 0) || (elapsed >= _duration)) {
+    return _to;
+  }
+  uint16_t t = uint16_t((uint64_t(elapsed) * 65535) / _duration);
+  int64_t eased = ease(t);
+  return uint16_t(_from + ((int64_t(_to) - _from) * eased) / 65535);
+}
+
+bool Fader::done(unsigned long now) {
+  return (now - _startTime) >= _duration;
+}
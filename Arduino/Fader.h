@@ -0,0 +1,66 @@
+/*!
+ * @file Fader.h
+ *
+ * @mainpage Arduino library for time based brightness fades
+ *
+ * @section intro_sec Introduction
+ *
+ * A Fader works out a brightness level (0..65535) from how long a fade
+ * has been running, shaped by an easing curve. Nothing has to happen at
+ * any particular step; whoever shows the frame asks for the level at
+ * that moment, so a fade takes the same time however often (or rarely)
+ * the strip is refreshed.
+ *
+ * The 16 bit level is finer than the LEDs can show; PaletteFrame dithers
+ * the difference over successive frames so low level fades stay smooth.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Fader.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef Fader_h
+#define Fader_h
+
+#define fadeLinear 0              // constant rate
+#define fadeQuadratic 1           // slow at both ends (quadratic ease in/out)
+#define fadeSine 2                // slow at both ends (half a cosine)
+
+/************************************************************************************
+ * start() a fade, then ask for level() whenever the frame is about to be shown
+ ************************************************************************************/
+class Fader {
+  public:
+    Fader();
+    void start(uint16_t fromLevel, uint16_t toLevel, unsigned long duration, int easing, unsigned long now);
+    uint16_t level(unsigned long now);    // brightness level at time now
+    bool done(unsigned long now);         // has the fade reached toLevel?
+
+  private:
+    uint16_t _from;
+    uint16_t _to;
+    unsigned long _startTime;
+    unsigned long _duration;              // milliseconds
+    int _easing;
+
+    uint16_t ease(uint16_t t);            // 0..65535 progress -> 0..65535 eased progress
+};
+
+#endif
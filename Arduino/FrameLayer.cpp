@@ -0,0 +1,173 @@
+/*!
+ * @file FrameLayer.cpp
+ *
+ * @mainpage Arduino library for layers drawn over a PaletteFrame
+ *
+ * @section intro_sec Introduction
+ *
+ * Spans of color blended over the frame as it is expanded. See
+ * FrameLayer.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * FrameLayer.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "FrameLayer.h"
+#include "AnimationGlobals.h"
+
+FrameLayer::FrameLayer() {
+  _spanCount = 0;
+  _mode = replaceBlend;
+  _alpha = 255;
+  _dirty = false;
+  _changedFirst = 0;
+  _changedLast = -1;
+}
+
+void FrameLayer::changed(int first, int last) {
+  if (!_dirty) {
+    _changedFirst = first;
+    _changedLast = last;
+    _dirty = true;
+  } else {
+    _changedFirst = min(_changedFirst, first);
+    _changedLast = max(_changedLast, last);
+  }
+}
+
+int FrameLayer::findSpan(int first, int last) {
+  for (int n=0; n<_spanCount; n++) {
+    if ((_spans[n].first == first) && (_spans[n].last == last)) {
+      return n;
+    }
+  }
+  return -1;
+}
+
+void FrameLayer::removeSpan(int n) {
+  changed(_spans[n].first, _spans[n].last);
+  _spanCount -= 1;
+  for (int i=n; i<_spanCount; i++) {        // keep the order, later spans blend on top
+    _spans[i] = _spans[i+1];
+  }
+}
+
+// every span looks different now
+void FrameLayer::setBlend(BlendMode mode, uint8_t alpha) {
+  _mode = mode;
+  _alpha = alpha;
+  for (int n=0; n<_spanCount; n++) {
+    changed(_spans[n].first, _spans[n].last);
+  }
+}
+
+void FrameLayer::setPixelColor(int i, uint32_t aColor) {
+  fill(aColor, i, i);
+}
+
+// a new span when the layer is full is dropped; layers are for a few indicators,
+// not for drawing
+void FrameLayer::fill(uint32_t aColor, int first, int last) {
+  if ((first < 0) || (last < first)) {
+    return;
+  }
+  int n = findSpan(first, last);
+  if (n >= 0) {
+    if (aColor == offColor) {
+      removeSpan(n);
+    } else if (_spans[n].color != aColor) {
+      _spans[n].color = aColor;
+      changed(first, last);
+    }
+    return;
+  }
+  if ((aColor == offColor) || (_spanCount >= kLayerSpans)) {
+    return;
+  }
+  _spans[_spanCount].first = first;
+  _spans[_spanCount].last = last;
+  _spans[_spanCount].color = aColor;
+  _spanCount += 1;
+  changed(first, last);
+}
+
+void FrameLayer::clear() {
+  while (_spanCount > 0) {
+    removeSpan(_spanCount - 1);
+  }
+}
+
+bool FrameLayer::dirty() {
+  return _dirty;
+}
+
+bool FrameLayer::takeChanged(int &first, int &last) {
+  if (!_dirty) {
+    return false;
+  }
+  first = _changedFirst;
+  last = _changedLast;
+  _dirty = false;
+  return true;
+}
+
+// for the power estimate; replaced pixels are still counted underneath, so it errs high
+uint32_t FrameLayer::weight() {
+  uint32_t sum = 0;
+  for (int n=0; n<_spanCount; n++) {
+    sum += colorWeight(_spans[n].color) * uint32_t(_spans[n].last - _spans[n].first + 1);
+  }
+  return sum;
+}
+
+/************************************************************************************
+ * blend the spans that overlap pixels first..first+count-1 onto grb (which holds
+ * those pixels); the span colors get the same brightness & dither as the frame
+ ************************************************************************************/
+void FrameLayer::blend(int first, int count, uint8_t *grb, uint16_t level, uint16_t dither) {
+  int last = first + count - 1;
+  for (int n=0; n<_spanCount; n++) {
+    const LayerSpan &aSpan = _spans[n];
+    if ((aSpan.first > last) || (aSpan.last < first)) {
+      continue;
+    }
+    uint8_t color[3];
+    scaleColorToGRB(aSpan.color, level, dither, color);
+    int start = max(aSpan.first, first);
+    int end = min(aSpan.last, last);
+    uint8_t *out = grb + 3*(start - first);
+    for (int i=start; i<=end; i++) {
+      for (int c=0; c<3; c++) {
+        switch (_mode) {
+          case replaceBlend:
+            out[c] = color[c];
+            break;
+          case addBlend:
+            out[c] = min(int(out[c]) + color[c], 255);
+            break;
+          case alphaBlend:
+            out[c] = out[c] + (((int(color[c]) - out[c]) * _alpha) / 255);
+            break;
+        }
+      }
+      out += 3;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/*!
+ * @file FrameLayer.h
+ *
+ * @mainpage Arduino library for layers drawn over a PaletteFrame
+ *
+ * @section intro_sec Introduction
+ *
+ * The animations own the frame's pixels; things that have to stay
+ * visible whatever the animation is doing (the PIR indicator LEDs, a
+ * warning) go in a layer above it instead, so the two don't overwrite
+ * each other. A layer is a short list of spans of LEDs, each a single
+ * color, and is blended onto the frame as it is expanded:
+ *   replaceBlend  the span's color replaces the frame's
+ *   addBlend      added to the frame's, saturating
+ *   alphaBlend    mixed with the frame's, alpha/255 of the span's color
+ * Setting a pixel or span to offColor removes it; where a layer has no
+ * span the frame shows through untouched.
+ *
+ * Each layer remembers the range of LEDs it has changed since it was
+ * last shown (its dirty flag), which the frame adds to its own dirty
+ * range. A layer that hasn't changed costs nothing but the blend of its
+ * own few pixels.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * FrameLayer.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef FrameLayer_h
+#define FrameLayer_h
+
+#define kLayerSpans 8                       // spans a layer can hold
+
+enum BlendMode { replaceBlend, addBlend, alphaBlend };
+
+struct LayerSpan {
+  int first;
+  int last;
+  uint32_t color;                           // 0x00RRGGBB
+};
+
+/************************************************************************************
+ * a few spans of color over the frame; see PaletteFrame::layer()
+ ************************************************************************************/
+class FrameLayer {
+  public:
+    FrameLayer();
+    void setBlend(BlendMode mode, uint8_t alpha=255);   // alpha is only used by alphaBlend
+    void setPixelColor(int i, uint32_t aColor);         // offColor -> pixel removed
+    void fill(uint32_t aColor, int first, int last);    // one span; offColor -> removed
+    void clear();                           // no spans, frame shows through
+    bool dirty();                           // changed since last shown?
+    bool takeChanged(int &first, int &last);    // range changed, dirty flag cleared; false if none
+    uint32_t weight();                      // colorWeight() summed over the lit LEDs
+    void blend(int first, int count, uint8_t *grb, uint16_t level, uint16_t dither);
+
+  private:
+    LayerSpan _spans[kLayerSpans];
+    int _spanCount;
+    BlendMode _mode;
+    uint8_t _alpha;
+    bool _dirty;
+    int _changedFirst;                      // LEDs changed since shown, when _dirty
+    int _changedLast;
+
+    void changed(int first, int last);
+    int findSpan(int first, int last);      // -1 if none with exactly those bounds
+    void removeSpan(int n);
+};
+
+#endif
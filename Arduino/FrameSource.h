@@ -0,0 +1,50 @@
+/*!
+ * @file FrameSource.h
+ *
+ * @mainpage Arduino library for anything an output can send
+ *
+ * @section intro_sec Introduction
+ *
+ * The outputs (see StripOutput.h) only ever ask a frame three things:
+ * which strip LEDs changed since it was last shown, the GRB bytes for
+ * some of them, and how many LEDs there are. A PaletteFrame answers
+ * them by expanding its indices; a frame prepared ahead of time (see
+ * RenderAhead.h) answers them from bytes it already has.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * FrameSource.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef FrameSource_h
+#define FrameSource_h
+
+/************************************************************************************
+ * what StripOutput::show() is handed; everything is in strip order
+ ************************************************************************************/
+class FrameSource {
+  public:
+    virtual ~FrameSource() {}
+    virtual bool dirtyRange(int &first, int &last) = 0;   // LEDs changed since last shown; false if none
+    virtual void expand(int first, int count, uint8_t *grb) = 0;  // 3 bytes per LED
+    virtual int stripPixels() = 0;          // LEDs the outputs send
+};
+
+#endif
@@ -0,0 +1,295 @@
+/*!
+ * @file IdleSleep.cpp
+ *
+ * @mainpage Arduino library for sleeping between PIR triggers
+ *
+ * @section intro_sec Introduction
+ *
+ * Standby with the RTC running on SAMD21 boards, emulated on a host
+ * computer. See IdleSleep.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * IdleSleep.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "IdleSleep.h"
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#include "wiring_private.h"               // pinPeripheral()
+#endif
+
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#define sleepSupported true
+#define kSleepGCLK 2                      // generic clock generator for the RTC & EIC
+#elif !defined(ARDUINO)
+#define sleepSupported true               // host: emulated
+#else
+#define sleepSupported false
+#endif
+
+static volatile bool PIRWoke = false;
+
+static void PIRWakeISR() {
+  PIRWoke = true;
+}
+
+/************************************************************************************
+ * SAMD21: RTC in 32 bit count mode at 1024 Hz, compare 0 is the wake up alarm
+ ************************************************************************************/
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+static void syncRTC() {
+  while (RTC->MODE0.STATUS.bit.SYNCBUSY) {
+  }
+}
+
+// COUNT is read continuously (startRTC() sets RCONT), so this doesn't wait for a
+// sync; the value lags by the same sync time whenever it's read
+static uint32_t readRTC() {
+  return RTC->MODE0.COUNT.reg;
+}
+
+void RTC_Handler() {
+  RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;  // the wake up is all it's for
+}
+
+static void startRTC() {
+  PM->APBAMASK.reg |= PM_APBAMASK_RTC;
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(kSleepGCLK) | GCLK_GENDIV_DIV(4);     // 2^(4+1): 32768 -> 1024 Hz
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(kSleepGCLK) | GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_DIVSEL |
+                      GCLK_GENCTRL_GENEN | GCLK_GENCTRL_RUNSTDBY;
+  while (GCLK->STATUS.bit.SYNCBUSY) {
+  }
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC | GCLK_CLKCTRL_GEN(kSleepGCLK) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {
+  }
+  RTC->MODE0.CTRL.reg &= ~RTC_MODE0_CTRL_ENABLE;
+  syncRTC();
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_SWRST;
+  while (RTC->MODE0.CTRL.reg & RTC_MODE0_CTRL_SWRST) {
+  }
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32 | RTC_MODE0_CTRL_PRESCALER_DIV1;
+  RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_CMP0;
+  NVIC_EnableIRQ(RTC_IRQn);
+  RTC->MODE0.CTRL.reg |= RTC_MODE0_CTRL_ENABLE;
+  syncRTC();
+  RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ | RTC_READREQ_RCONT | RTC_READREQ_ADDR(0x10);   // COUNT
+  syncRTC();
+}
+
+// attachInterrupt() clocks the EIC from the main clock, which stops in standby
+static void clockEIC() {
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_EIC | GCLK_CLKCTRL_GEN(kSleepGCLK) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {
+  }
+  EIC->CTRL.bit.ENABLE = 1;               // attachInterrupt() doesn't if the NMI is the only pin
+  while (EIC->STATUS.bit.SYNCBUSY) {
+  }
+}
+
+static void wakeOnPin(int pin) {
+  EIC->WAKEUP.reg |= (1 << g_APinDescription[pin].ulExtInt);
+}
+
+// attachInterrupt() ignores the NMI (PA08, the Trinket's pin 0); it needs no
+// WAKEUP bit, any NMI wakes the processor
+static void wakeOnNMI(int pin, int edge) {
+  pinPeripheral(pin, PIO_EXTINT);
+  EIC->NMIFLAG.reg = EIC_NMIFLAG_NMI;
+  EIC->NMICTRL.reg = (edge == RISING) ? EIC_NMICTRL_NMISENSE_RISE : EIC_NMICTRL_NMISENSE_FALL;
+}
+
+void NMI_Handler() {
+  EIC->NMIFLAG.reg = EIC_NMIFLAG_NMI;
+  PIRWoke = true;
+}
+#endif
+
+// the pin's external interrupt, NOT_AN_INTERRUPT if it has none
+static int wakeInterrupt(int pin) {
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+  return g_APinDescription[pin].ulExtInt;
+#else
+  return digitalPinToInterrupt(pin);
+#endif
+}
+
+IdleSleep::IdleSleep() {
+  _pinCount = 0;
+  _activeLevel = HIGH;
+  _started = false;
+  _sleptTicks = 0;
+  _sleeps = 0;
+  _asleepMillis = 0;
+  _PIRWakes = 0;
+  _wakeMicros = 0;
+  _latencyPending = false;
+  _latencyCount = 0;
+  _latencyTotal = 0;
+  _latencyMax = 0;
+}
+
+// a PIR that couldn't wake us would be missed while asleep, so then we never sleep
+bool IdleSleep::begin(const int *pins, int count, int activeLevel) {
+  _pinCount = min(count, kSleepWakePins);
+  for (int i=0; i<_pinCount; i++) {
+    _pins[i] = pins[i];
+  }
+  _activeLevel = activeLevel;
+  if (!sleepSupported) {
+    return false;
+  }
+  for (int i=0; i<_pinCount; i++) {
+    if (wakeInterrupt(_pins[i]) == NOT_AN_INTERRUPT) {
+      Serial.print("IdleSleep: pin "); Serial.print(_pins[i]);
+      Serial.println(" has no interrupt to wake us, so no sleeping");
+      return false;
+    }
+  }
+  int edge = (activeLevel == HIGH) ? RISING : FALLING;
+  for (int i=0; i<_pinCount; i++) {
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+    if (wakeInterrupt(_pins[i]) == EXTERNAL_INT_NMI) {
+      wakeOnNMI(_pins[i], edge);
+      continue;
+    }
+#endif
+    attachInterrupt(digitalPinToInterrupt(_pins[i]), PIRWakeISR, edge);
+  }
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+  startRTC();
+  clockEIC();
+  for (int i=0; i<_pinCount; i++) {
+    if (wakeInterrupt(_pins[i]) != EXTERNAL_INT_NMI) {
+      wakeOnPin(_pins[i]);
+    }
+  }
+#endif
+  _started = true;
+  return true;
+}
+
+bool IdleSleep::PIRActive() {
+  for (int i=0; i<_pinCount; i++) {
+    if (digitalRead(_pins[i]) == _activeLevel) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IdleSleep::usbConnected() {
+#if defined(ARDUINO_ARCH_SAMD) && defined(USBCON)
+  return USBDevice.connected();
+#elif !defined(ARDUINO)
+  return bool(Serial);                    // host: see hostSerialConnected()
+#else
+  return false;
+#endif
+}
+
+/************************************************************************************
+ * interrupts are off from the last look at the PIRs until the processor is asleep,
+ * so an edge in between can't be missed: it leaves the interrupt pending and the
+ * processor doesn't go to sleep at all. The NMI can't be held off; its handler
+ * runs at once, so PIRWoke is checked again right before the WFI. An edge in the
+ * couple of instructions left leaves us asleep until the RTC alarm.
+ *
+ * Any pending interrupt ends the WFI at once, so nothing that waits on the RTC's
+ * 1024 Hz clock (the alarm's sync takes a few ms) is done with interrupts off, and
+ * the SysTick interrupt is turned off while they are. millis() misses the ticks
+ * from then until it's back on; that time is counted from the RTC for now().
+ ************************************************************************************/
+bool IdleSleep::sleep(unsigned long ms) {
+  if (!_started || (ms < kMinimumSleep) || usbConnected()) {
+    return false;
+  }
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+  uint32_t alarm = readRTC() + uint32_t((uint64_t(ms) * kSleepTicksPerSecond) / 1000);
+  RTC->MODE0.COMP[0].reg = alarm;
+  syncRTC();
+  RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+  PIRWoke = false;
+  noInterrupts();
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+  uint32_t start = readRTC();
+  if (PIRActive() || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || (int32_t(alarm - start) < 2)) {
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;      // motion, a tick due or the alarm passing
+    interrupts();
+    return false;
+  }
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  if (!PIRWoke) {
+    __WFI();                              // standby; a pending interrupt wakes us even now
+  }
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  uint32_t ticks = readRTC() - start;
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+  interrupts();                           // let the PIR/RTC handler run
+  _sleptTicks += ticks;
+  _asleepMillis += (uint64_t(ticks) * 1000) / kSleepTicksPerSecond;
+#elif !defined(ARDUINO)
+  PIRWoke = false;
+  noInterrupts();
+  if (PIRActive()) {
+    interrupts();
+    return false;
+  }
+  uint64_t start = hostMicros();
+  interrupts();
+  hostStandby(start + uint64_t(ms) * 1000);
+  _asleepMillis += (hostMicros() - start) / 1000;
+#endif
+  _sleeps += 1;
+  if (PIRWoke) {
+    _PIRWakes += 1;
+    _wakeMicros = micros();
+    _latencyPending = true;
+  }
+  return true;
+}
+
+bool IdleSleep::wokenByPIR() {
+  return PIRWoke;
+}
+
+unsigned long IdleSleep::now() {
+  return millis() + (unsigned long)((_sleptTicks * 1000) / kSleepTicksPerSecond);
+}
+
+unsigned long IdleSleep::lit() {
+  if (!_latencyPending) {
+    return 0;
+  }
+  _latencyPending = false;
+  unsigned long latency = micros() - _wakeMicros;
+  _latencyCount += 1;
+  _latencyTotal += latency;
+  _latencyMax = max(_latencyMax, latency);
+  return latency;
+}
+
+void IdleSleep::printStats() {
+  Serial.print("IdleSleep sleeps: "); Serial.print(_sleeps);
+  Serial.print(" PIR wakes: "); Serial.print(_PIRWakes);
+  Serial.print(" asleep s: "); Serial.print(_asleepMillis / 1000);
+  Serial.print(" wake to light us avg: ");
+  Serial.print(_latencyCount ? _latencyTotal / _latencyCount : 0);
+  Serial.print(" max: "); Serial.println(_latencyMax);
+}
@@ -0,0 +1,107 @@
+/*!
+ * @file IdleSleep.h
+ *
+ * @mainpage Arduino library for sleeping between PIR triggers
+ *
+ * @section intro_sec Introduction
+ *
+ * When the stairs are dark and nobody is on them there is nothing for
+ * loop() to do but poll. sleep() instead puts the processor in standby
+ * until a PIR output goes active or a given time has passed, whichever
+ * comes first.
+ *
+ * In standby the SysTick timer stops, so millis() stops too (its
+ * interrupt is also off for the moments either side, so a pending tick
+ * can't cut the sleep short). The time spent asleep is counted by the RTC (a 32 bit counter at 1024 Hz from
+ * the ultra low power 32kHz oscillator) and now() adds it back:
+ * anything that has to stay in step with the real time of day (the
+ * light level sampling, the state machine's timeouts) should use now()
+ * rather than millis(). Intervals measured entirely while awake (PIR
+ * debounce, animations) can keep using millis(). micros() stops too, so
+ * the event log's times leave the sleeps out; the evWoken records say
+ * how long each one was.
+ *
+ * Each wake by a PIR starts a latency measurement, from the processor
+ * running again to lit() being called (the first frame of the
+ * animation the motion started). The oscillator start up before the
+ * processor runs (a few us on a SAMD21) isn't included.
+ *
+ * Only the SAMD21 (Trinket M0) is supported; elsewhere sleep() returns
+ * false and the sketch carries on polling. On a host computer the
+ * standby is emulated with hostStandby() (see host/HostArduino.h),
+ * where the virtual clock keeps running, so now() == millis().
+ *
+ * The RTC uses generic clock generator 2, which also becomes the clock
+ * of the external interrupt controller so the PIR edges are seen in
+ * standby. Nothing else in the sketch uses either. A PIR on the pin
+ * whose external interrupt is the NMI (pin 0 on the Trinket M0, which
+ * attachInterrupt() won't take) wakes us through the EIC's NMI control
+ * instead. If any PIR pin has no external interrupt at all begin() says
+ * so on Serial and returns false, and sleep() never sleeps.
+ *
+ * USB doesn't survive standby, so there is no sleeping while a USB
+ * host has the board configured (e.g. while debugging). Battery and
+ * plug-pack installs never have one.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * IdleSleep.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef IdleSleep_h
+#define IdleSleep_h
+
+#define kSleepTicksPerSecond 1024         // RTC count rate
+#define kMinimumSleep 20                  // ms; shorter sleeps aren't worth the bother
+#define kSleepWakePins 8                  // PIRs that can wake us
+
+/************************************************************************************
+ * begin() once with the PIR pins, then sleep() whenever there's nothing to do
+ ************************************************************************************/
+class IdleSleep {
+  public:
+    IdleSleep();
+    bool begin(const int *pins, int count, int activeLevel=HIGH);   // the PIRs wake us; false -> never sleeps
+    bool sleep(unsigned long ms);         // false -> didn't sleep (PIR active, USB, too short...)
+    bool wokenByPIR();                    // did the last sleep end with motion?
+    unsigned long now();                  // millis() plus the time spent asleep
+    unsigned long lit();                  // first lit frame after a PIR wake; returns latency in us, 0 if none
+    void printStats();                    // sleeps, time asleep and wake to light latencies
+
+  private:
+    int _pins[kSleepWakePins];
+    int _pinCount;
+    int _activeLevel;                     // PIR output level that means motion
+    bool _started;
+    uint64_t _sleptTicks;                 // RTC ticks millis() missed (standby, SysTick off), ever
+    unsigned long _sleeps;
+    unsigned long _asleepMillis;          // total, for printStats()
+    unsigned long _PIRWakes;
+    unsigned long _wakeMicros;            // micros() when the last PIR wake ran again
+    bool _latencyPending;                 // woken by a PIR, lit() not called yet
+    unsigned long _latencyCount;
+    unsigned long _latencyTotal;          // us
+    unsigned long _latencyMax;
+
+    bool PIRActive();
+    bool usbConnected();
+};
+
+#endif
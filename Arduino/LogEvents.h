@@ -0,0 +1,56 @@
+/*!
+ * @file LogEvents.h
+ *
+ * @mainpage The events EventLog can record
+ *
+ * @section intro_sec Introduction
+ *
+ * One LOG_EVENT_ENTRY(name, "text") per event. The position in the list
+ * is the event's id in the log, so add new events at the end. The text
+ * is only used by the decoder (host/decodeLog.py reads this file), never
+ * on the board; {a} and {b} in it are replaced by the event's arguments
+ * (a is 16 bits, b is 32 bits, both signed).
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * LogEvents.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+// no include guard: included more than once with different LOG_EVENT_ENTRY definitions
+
+LOG_EVENT_ENTRY(evLogDropped, "{b} log records dropped")
+LOG_EVENT_ENTRY(evMotionDuringBoot, "-> motion during start up")
+LOG_EVENT_ENTRY(evPIRStates, "PIRs active: {a} (a bit each, bottom first), going {b} (1 up, -1 down)")
+LOG_EVENT_ENTRY(evTopTriggered, "-> entered flight {b} at the top; {a} on it")
+LOG_EVENT_ENTRY(evBottomTriggered, "-> entered flight {b} at the bottom; {a} on it")
+LOG_EVENT_ENTRY(evTopThenBottom, "-> top walker left flight {b} at the bottom; {a} on it")
+LOG_EVENT_ENTRY(evBottomThenTop, "-> bottom walker left flight {b} at the top; {a} on it")
+LOG_EVENT_ENTRY(evNoBottomTrigger, "-> top walker not seen leaving flight {b}; {a} on it")
+LOG_EVENT_ENTRY(evNoTopTrigger, "-> bottom walker not seen leaving flight {b}; {a} on it")
+LOG_EVENT_ENTRY(evTimeoutDone, "-> flight {b} empty; finishing from {a} (0 bottom, 1 top)")
+LOG_EVENT_ENTRY(evAnimationChosen, "animation {b} from table {a} (0 fade, 1 dim, 2 brighter)")
+LOG_EVENT_ENTRY(evLightLevel, "light level: {b}")
+LOG_EVENT_ENTRY(evLightLevelSkipped, "light level not read, animation active; using {b}")
+LOG_EVENT_ENTRY(evDebugLightLevel, "debugLightLevel: {b}")
+LOG_EVENT_ENTRY(evDebugFadeMode, "debugFadeMode: {a}")
+LOG_EVENT_ENTRY(evFadingColorWipe, "Fading mode && ColorWipe, light level {b}")
+LOG_EVENT_ENTRY(evMappedBrightness, "mappedBrightness {b} -> {a}")
+LOG_EVENT_ENTRY(evRemapThresholds, "remapLightLevelThresholds, range {a}..{b}")
+LOG_EVENT_ENTRY(evCalibrationSaved, "light calibration saved, {b} records written")
+LOG_EVENT_ENTRY(evWoken, "woke after {b} ms asleep, by {a} (0 timer, 1 PIR)")
+LOG_EVENT_ENTRY(evWakeToLight, "lit {b} us after a PIR woke us")
@@ -0,0 +1,157 @@
+/*!
+ * @file NetworkOutput.cpp
+ *
+ * @mainpage Arduino library for sending frames to LED controllers over UDP
+ *
+ * @section intro_sec Introduction
+ *
+ * DDP and E1.31 packet building. Multi-byte header fields are big-endian
+ * in both protocols.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * NetworkOutput.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "NetworkOutput.h"
+
+static void putBigEndian16(uint8_t *p, uint16_t value) {
+  p[0] = value >> 8;
+  p[1] = value;
+}
+
+static void putBigEndian32(uint8_t *p, uint32_t value) {
+  putBigEndian16(p, value >> 16);
+  putBigEndian16(p + 2, value);
+}
+
+// expand pixels first..first+count-1 as RGB and write them to the open packet
+static void writePixels(UDP &udp, FrameSource &aFrame, int first, int count) {
+  uint8_t bytes[kOutputChunk*3];
+  int end = first + count;
+  for (int i=first; i<end; i+=kOutputChunk) {
+    int n = min(kOutputChunk, end-i);
+    aFrame.expand(i, n, bytes);
+    swapGRBtoRGB(bytes, n);
+    udp.write(bytes, n*3);
+  }
+}
+
+/************************************************************************************
+ * DDPOutput
+ ************************************************************************************/
+DDPOutput::DDPOutput(UDP &udp, IPAddress destination, uint16_t port) : _udp(udp) {
+  _destination = destination;
+  _port = port;
+  _sequence = 0;
+  _packets = 0;
+}
+
+// the UDP is begun by its owner (usually once the network is up)
+void DDPOutput::begin() {
+}
+
+void DDPOutput::show(FrameSource &aFrame) {
+  const int pixelsPerPacket = kDDPMaxData/3;
+  int numPixels = aFrame.stripPixels();
+  _sequence = (_sequence % 15) + 1;
+  for (int first=0; first<numPixels; first+=pixelsPerPacket) {
+    int count = min(pixelsPerPacket, numPixels-first);
+    bool last = (first + count) >= numPixels;
+    uint8_t header[kDDPHeaderBytes];
+    header[0] = 0x40 | (last ? 0x01 : 0x00);    // version 1, PUSH on the last packet
+    header[1] = _sequence;
+    header[2] = kDDPTypeRGB8;
+    header[3] = 1;                              // id: the default output device
+    putBigEndian32(&header[4], uint32_t(first)*3);  // byte offset into the display
+    putBigEndian16(&header[8], count*3);
+    _udp.beginPacket(_destination, _port);
+    _udp.write(header, kDDPHeaderBytes);
+    writePixels(_udp, aFrame, first, count);
+    _udp.endPacket();
+    _packets += 1;
+  }
+}
+
+unsigned long DDPOutput::packetsSent() {
+  return _packets;
+}
+
+/************************************************************************************
+ * E131Output
+ ************************************************************************************/
+static const uint8_t e131CID[16] = {              // identifies this sender; any fixed value
+  0x73, 0x74, 0x61, 0x69, 0x72, 0x77, 0x61, 0x79,
+  0x2D, 0x73, 0x74, 0x72, 0x69, 0x70, 0x00, 0x01
+};
+
+E131Output::E131Output(UDP &udp, IPAddress destination, uint16_t firstUniverse, uint16_t port) : _udp(udp) {
+  _destination = destination;
+  _port = port;
+  _firstUniverse = firstUniverse;
+  _sequence = 0;
+  _packets = 0;
+}
+
+void E131Output::begin() {
+}
+
+// root, framing and DMP layers; each layer's length counts from its start to the
+// end of the packet
+void E131Output::writeHeader(uint16_t universe, int channels) {
+  uint8_t header[kE131HeaderBytes];
+  int length = kE131HeaderBytes + channels;
+  memset(header, 0, sizeof(header));
+  putBigEndian16(&header[0], 0x0010);           // preamble size
+  memcpy(&header[4], "ASC-E1.17", 9);           // ACN packet identifier (zero padded)
+  putBigEndian16(&header[16], 0x7000 | (length - 16));
+  putBigEndian32(&header[18], 0x00000004);      // root vector: E1.31 data
+  memcpy(&header[22], e131CID, sizeof(e131CID));
+  putBigEndian16(&header[38], 0x7000 | (length - 38));
+  putBigEndian32(&header[40], 0x00000002);      // framing vector: DMP data
+  strncpy((char *)&header[44], "stairway", 64); // source name
+  header[108] = kE131Priority;
+  header[111] = _sequence;
+  putBigEndian16(&header[113], universe);
+  putBigEndian16(&header[115], 0x7000 | (length - 115));
+  header[117] = 0x02;                           // DMP vector: set property
+  header[118] = 0xA1;                           // address & data type
+  putBigEndian16(&header[121], 0x0001);         // address increment
+  putBigEndian16(&header[123], channels + 1);   // start code + channels
+  _udp.write(header, kE131HeaderBytes);
+}
+
+void E131Output::show(FrameSource &aFrame) {
+  int numPixels = aFrame.stripPixels();
+  uint16_t universe = _firstUniverse;
+  _sequence += 1;
+  for (int first=0; first<numPixels; first+=kE131PixelsPerUniverse) {
+    int count = min(kE131PixelsPerUniverse, numPixels-first);
+    _udp.beginPacket(_destination, _port);
+    writeHeader(universe, count*3);
+    writePixels(_udp, aFrame, first, count);
+    _udp.endPacket();
+    _packets += 1;
+    universe += 1;
+  }
+}
+
+unsigned long E131Output::packetsSent() {
+  return _packets;
+}
@@ -0,0 +1,99 @@
+/*!
+ * @file NetworkOutput.h
+ *
+ * @mainpage Arduino library for sending frames to LED controllers over UDP
+ *
+ * @section intro_sec Introduction
+ *
+ * Two common ways of sending pixels over a network:
+ *  DDPOutput   Distributed Display Protocol (port 4048), 480 RGB pixels
+ *              per packet, the last packet of a frame has PUSH set so the
+ *              controller shows the whole frame at once
+ *  E131Output  E1.31 (sACN, port 5568), 170 RGB pixels per DMX universe,
+ *              consecutive universes from firstUniverse
+ *
+ * Both write through any Arduino UDP (WiFiUDP, EthernetUDP, ...), which
+ * must already have been begun, a few pixels at a time, so no frame sized packet buffer is needed. On a host
+ * computer host/HostIO.h provides a UDP that uses sockets; sending to
+ * 127.0.0.1 works for testing.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * NetworkOutput.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <IPAddress.h>
+#include <Udp.h>
+#include "StripOutput.h"
+
+#ifndef NetworkOutput_h
+#define NetworkOutput_h
+
+#define kDDPPort 4048
+#define kDDPHeaderBytes 10
+#define kDDPMaxData 1440                    // 480 RGB pixels, fits an ethernet frame
+#define kDDPTypeRGB8 0x0B                   // data type: RGB, 8 bits per channel
+
+#define kE131Port 5568
+#define kE131HeaderBytes 126
+#define kE131PixelsPerUniverse 170          // 510 of the 512 DMX channels
+#define kE131Priority 100
+
+/************************************************************************************
+ * DDP: one frame is as many packets as it takes, each with its byte offset
+ ************************************************************************************/
+class DDPOutput : public StripOutput {
+  public:
+    DDPOutput(UDP &udp, IPAddress destination, uint16_t port=kDDPPort);
+    void begin();
+    void show(FrameSource &aFrame);
+    const char *name() { return "DDP"; }
+    unsigned long packetsSent();
+
+  private:
+    UDP &_udp;
+    IPAddress _destination;
+    uint16_t _port;
+    uint8_t _sequence;                      // 1..15, 0 means "not used" to receivers
+    unsigned long _packets;
+};
+
+/************************************************************************************
+ * E1.31: one packet per universe, each with its own sequence number
+ ************************************************************************************/
+class E131Output : public StripOutput {
+  public:
+    E131Output(UDP &udp, IPAddress destination, uint16_t firstUniverse=1, uint16_t port=kE131Port);
+    void begin();
+    void show(FrameSource &aFrame);
+    const char *name() { return "E1.31"; }
+    unsigned long packetsSent();
+
+  private:
+    UDP &_udp;
+    IPAddress _destination;
+    uint16_t _port;
+    uint16_t _firstUniverse;
+    uint8_t _sequence;                      // one per frame, the same for all its universes
+    unsigned long _packets;
+
+    void writeHeader(uint16_t universe, int channels);
+};
+
+#endif
@@ -35,8 +35,11 @@
 #include "Arduino.h"
 #include "PIR.h"
 #include <Adafruit_NeoPixel.h>
+#include "PaletteFrame.h"
+#include "Profiler.h"
+#include "TraceLog.h"
 
-unsigned long stableStateMinimum = 100; // milliseconds
+unsigned long stableStateMinimum = kStableStateMinimum; // milliseconds
 
 /************************************************************************************
  * read() includes code to simulate a PIR being connected when debugging is enabled
@@ -53,6 +56,8 @@ PIR::PIR(int pin, int indicatorIndex, const char *name, bool debug) {
   _indicatorIndex = indicatorIndex;
   _PIRTransitionTime = 0;
   _reportedState = false;
+  _previousState = false;
+  _stableTime = stableStateMinimum;
 }
 
 // raw state of the PIR
@@ -64,18 +69,25 @@ bool PIR::readRaw() {
 
 // normally used to read PIR state
 bool PIR::read() {
+  PROFILE_ZONE(zonePIRRead);
   bool state = readRaw();
   unsigned long now = millis();
-// reflect current state in indicators
+// reflect current state in indicators, drawn over whatever the animation is doing
   if (state != _previousState) {     // show changes whether we report them or not
-    uint32_t color = (state) ? indicatorColor : offColor;
-    pixels.setPixelColor(_indicatorIndex, color);
-    pixels.show();
+    if (_indicatorIndex >= 0) {
+      uint32_t color = (state) ? indicatorColor : offColor;
+      frame.layer(kOverlayLayer).setPixelColor(_indicatorIndex, color);
+      frame.show();
+    }
+    TRACE_INSTANT(trPIREdge, _pin, state);
     _PIRTransitionTime = now;
     _previousState = state;
   }
 // now determine what to report (debounce too)
-  if ((now - _PIRTransitionTime) > stableStateMinimum) {
+  if ((now - _PIRTransitionTime) > _stableTime) {
+    if (state != _reportedState) {
+      TRACE_INSTANT(trPIRSettled, _pin, state);
+    }
     _PIRTransitionTime = now;
     _reportedState = state;
   }
@@ -85,3 +97,15 @@ bool PIR::read() {
 bool PIR::debugMode() {
   return _debug;
 }
+
+int PIR::pin() {
+  return _pin;
+}
+
+int PIR::indicator() {
+  return _indicatorIndex;
+}
+
+void PIR::setStableTime(unsigned long ms) {
+  _stableTime = ms;
+}
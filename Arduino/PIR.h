@@ -11,7 +11,10 @@
  * 
  * The class also handles lighting an indicator LED on an externally
  * defined neopixel strip. Indicator index in strip is defined at 
- * constructor time.
+ * constructor time; a PIR without one (index <0) never touches the frame.
+ *
+ * A change has to last stableTime ms (stableStateMinimum unless
+ * setStableTime() says otherwise) before read() reports it.
  *
  * @section author Author
  * 
@@ -41,6 +44,8 @@
 #include <Adafruit_NeoPixel.h>
 #include "AnimationGlobals.h"
 
+#define kStableStateMinimum 100           // ms a change must last, unless setStableTime() says otherwise
+
 /************************************************************************************
  * read() includes code to simulate a PIR being connected when debugging is enabled
  ************************************************************************************/
@@ -51,6 +56,9 @@ class PIR
     bool read();                  // normal read function
     bool readRaw();               // returns current state, no filtering
     bool debugMode();             // returns debug setting
+    int pin();
+    int indicator();              // LED strip index of the indicator, <0 if none
+    void setStableTime(unsigned long ms);   // debounce for this PIR
     const char *PIRName;
 
   private:
@@ -59,6 +67,7 @@ class PIR
     bool _reportedState;          // state from last time we read this PIR
     bool _previousState;          // internally used for debounce
     int _indicatorIndex;          // LED strip index for indicator; <0 says no indicator
+    unsigned long _stableTime;    // ms a change must last to be reported
     bool _debug;
 };
 
@@ -0,0 +1,486 @@
+/*!
+ * @file PaletteFrame.cpp
+ *
+ * @mainpage Arduino library for a palette-indexed NeoPixel frame buffer
+ *
+ * @section intro_sec Introduction
+ *
+ * Keeps a 4 or 8 bit palette index per LED and expands the indices to
+ * GRB bytes only when the frame is shown.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PaletteFrame.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "PaletteFrame.h"
+#include "AnimationGlobals.h"
+#include "StripOutput.h"
+#include "Profiler.h"
+#include "TraceLog.h"
+
+/************************************************************************************
+ * Constructor; the frame storage is sized by kNumberOfLEDs, numPixels may be less
+ ************************************************************************************/
+PaletteFrame::PaletteFrame(int numPixels) {
+  _numPixels = numPixels;
+  if (_numPixels > kNumberOfLEDs) {
+    _numPixels = kNumberOfLEDs;
+  }
+  _level = 65535;
+  _shownLevel = 65535;
+  _powerBudget = 0;
+  _dither = 0;
+  _output = NULL;
+  _map = NULL;
+  _patternFirst = 1;                        // no pattern,
+  _patternLast = 0;
+  _dirtyFirst = 1;                          // nothing changed, yet
+  _dirtyLast = 0;
+  begin();
+}
+
+// every pixel black, every palette entry but 0 free
+void PaletteFrame::begin() {
+  memset(_indices, 0, sizeof(_indices));
+  for (int i=0; i<kPaletteSize; i++) {
+    _palette[i] = 0;
+    _paletteUse[i] = 0;
+  }
+  _paletteUse[0] = _numPixels;              // entry 0 is black and is never freed
+  _weightSum = 0;
+  _lastIndex = 0;
+  _scaledValid = false;
+  clearPattern();
+  for (int n=0; n<kFrameLayers; n++) {
+    _layers[n].clear();
+  }
+  markAllDirty();
+}
+
+uint32_t PaletteFrame::Color(uint8_t r, uint8_t g, uint8_t b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+int PaletteFrame::numPixels() {
+  return _numPixels;
+}
+
+/************************************************************************************
+ * palette management
+ ************************************************************************************/
+// find aColor in the palette, or put it in a free entry. A free entry returned
+// here isn't owned by anyone until setPixelIndex() uses it.
+int PaletteFrame::paletteIndex(uint32_t aColor) {
+  if (_palette[_lastIndex] == aColor) {     // same as last time? (fills, wipes...)
+    if (_paletteUse[_lastIndex] == 0) {     // freed since; its scaled copy may be stale
+      scaleEntry(_lastIndex);
+    }
+    return _lastIndex;
+  }
+  int freeIdx = -1;
+  for (int i=0; i<kPaletteSize; i++) {
+    if (_palette[i] == aColor && ((_paletteUse[i] != 0) || (i == 0))) {
+      _lastIndex = i;
+      return i;
+    }
+    if ((freeIdx < 0) && (_paletteUse[i] == 0) && (i != 0)) {
+      freeIdx = i;
+    }
+  }
+  if (freeIdx < 0) {                        // palette full, make do
+    return nearestIndex(aColor);
+  }
+  _palette[freeIdx] = aColor;
+  scaleEntry(freeIdx);
+  _lastIndex = freeIdx;
+  return freeIdx;
+}
+
+// closest color already in the palette (sum of component differences)
+int PaletteFrame::nearestIndex(uint32_t aColor) {
+  int best = 0;
+  long bestDistance = 0x7FFFFFFF;
+  for (int i=0; i<kPaletteSize; i++) {
+    uint32_t c = _palette[i];
+    long distance = abs(int((c >> 16) & 0xFF) - int((aColor >> 16) & 0xFF))
+                  + abs(int((c >> 8) & 0xFF) - int((aColor >> 8) & 0xFF))
+                  + abs(int(c & 0xFF) - int(aColor & 0xFF));
+    if (distance < bestDistance) {
+      bestDistance = distance;
+      best = i;
+    }
+  }
+  return best;
+}
+
+// apply brightness to one palette entry, stored in the GRB order of NEO_GRB
+void PaletteFrame::scaleEntry(int idx) {
+  scaleColorToGRB(_palette[idx], _shownLevel, _dither, _scaled[idx]);
+}
+
+/************************************************************************************
+ * pixel access
+ ************************************************************************************/
+uint8_t PaletteFrame::getPixelIndex(int i) {
+#if kFrameBitsPerPixel == 8
+  return _indices[i];
+#else
+  uint8_t packed = _indices[i >> 1];
+  return (i & 1) ? (packed >> 4) : (packed & 0x0F);
+#endif
+}
+
+void PaletteFrame::setPixelIndex(int i, uint8_t idx) {
+  if ((i < 0) || (i >= _numPixels)) {       // same forgiveness as Adafruit_NeoPixel
+    return;
+  }
+  uint8_t old = getPixelIndex(i);
+  if (old == idx) {
+    return;
+  }
+  _paletteUse[old] -= 1;                    // old entry may now be free
+  _paletteUse[idx] += 1;
+  changeWeight(i, old, idx);
+  markDirty(i, i);
+#if kFrameBitsPerPixel == 8
+  _indices[i] = idx;
+#else
+  uint8_t &packed = _indices[i >> 1];
+  if (i & 1) {
+    packed = (packed & 0x0F) | (idx << 4);
+  } else {
+    packed = (packed & 0xF0) | (idx & 0x0F);
+  }
+#endif
+}
+
+// keep the power model's totals up to date as a pixel changes palette entry
+void PaletteFrame::changeWeight(int i, uint8_t old, uint8_t idx) {
+  uint32_t delta = colorWeight(_palette[idx]) - colorWeight(_palette[old]);   // wraps, fine
+  _weightSum += delta;
+  if ((i >= _patternFirst) && (i <= _patternLast)) {
+    _hiddenWeight += delta;
+  }
+}
+
+void PaletteFrame::setPixelColor(int i, uint32_t aColor) {
+  if ((i < 0) || (i >= _numPixels)) {
+    return;
+  }
+  setPixelIndex(i, paletteIndex(aColor));
+}
+
+uint32_t PaletteFrame::getPixelColor(int i) {
+  if ((i < 0) || (i >= _numPixels)) {
+    return 0;
+  }
+  return _palette[getPixelIndex(i)];
+}
+
+void PaletteFrame::fill(uint32_t aColor, int first, int count) {
+  if (count <= 0) {
+    count = _numPixels - first;
+  }
+  uint8_t idx = paletteIndex(aColor);
+  for (int i=first; i<first+count; i++) {
+    setPixelIndex(i, idx);
+  }
+}
+
+/************************************************************************************
+ * brightness is applied to the (small) palette rather than to every pixel
+ ************************************************************************************/
+void PaletteFrame::setBrightness(uint8_t brightness) {
+  setBrightnessLevel(uint16_t(brightness) * 257);   // 255 -> 65535
+}
+
+uint8_t PaletteFrame::getBrightness() {
+  return _level >> 8;
+}
+
+void PaletteFrame::setBrightnessLevel(uint16_t level) {
+  _level = level;
+  limitPower();
+}
+
+uint16_t PaletteFrame::getBrightnessLevel() {
+  return _level;
+}
+
+uint16_t PaletteFrame::shownLevel() {
+  return _shownLevel;
+}
+
+// full (or no) brightness needs no rounding; anything else gets a new rounding
+// offset each show(). The golden ratio step spreads the offsets evenly.
+void PaletteFrame::nextDither() {
+  uint16_t dither = 0;
+  if ((_shownLevel != 0) && (_shownLevel != 65535)) {
+    dither = _dither + 40503;
+  }
+  if (dither != _dither) {
+    _dither = dither;
+    _scaledValid = false;
+  }
+}
+
+/************************************************************************************
+ * power limiting: the totals are kept by setPixelIndex() & usePattern(), so this is
+ * a few multiplies per frame however long the strip is
+ ************************************************************************************/
+void PaletteFrame::setPowerBudget(uint16_t milliamps) {
+  _powerBudget = milliamps;
+  limitPower();
+}
+
+uint32_t PaletteFrame::fullMilliamps() {
+  uint32_t weight = _weightSum - _hiddenWeight;
+  if (_patternFirst <= _patternLast) {
+    weight += _pattern.weight(_patternLast - _patternFirst + 1);
+  }
+  for (int n=0; n<kFrameLayers; n++) {
+    weight += _layers[n].weight();
+  }
+  return uint32_t((uint64_t(weight) * kMilliampsPerChannel) / 255);
+}
+
+uint32_t PaletteFrame::estimatedMilliamps() {
+  uint32_t idle = uint32_t(stripPixels()) * kIdleMicroampsPerLED / 1000;
+  return idle + uint32_t((uint64_t(fullMilliamps()) * (uint32_t(_shownLevel) + 1)) >> 16);
+}
+
+// the highest level (up to the one asked for) whose estimate fits the budget
+void PaletteFrame::limitPower() {
+  uint16_t level = _level;
+  if (_powerBudget != 0) {
+    uint32_t idle = uint32_t(stripPixels()) * kIdleMicroampsPerLED / 1000;
+    uint32_t available = (_powerBudget > idle) ? _powerBudget - idle : 0;
+    uint32_t full = fullMilliamps();
+    if (((uint64_t(full) * (uint32_t(level) + 1)) >> 16) > available) {
+      uint32_t fits = uint32_t((uint64_t(available) << 16) / full);   // full > available here
+      level = (fits > 0) ? fits - 1 : 0;
+    }
+  }
+  if (level != _shownLevel) {
+    _shownLevel = level;
+    _scaledValid = false;
+  }
+}
+
+/************************************************************************************
+ * periodic pattern support
+ ************************************************************************************/
+PeriodicPattern &PaletteFrame::pattern() {
+  return _pattern;
+}
+
+// the pixels the pattern hides are counted once here, then kept up to date by
+// setPixelIndex()
+void PaletteFrame::usePattern(int first, int last) {
+  markDirty(_patternFirst, _patternLast);   // what it used to cover goes back to the pixels
+  _patternFirst = max(first, 0);
+  _patternLast = min(last, _numPixels-1);
+  _hiddenWeight = 0;
+  for (int i=_patternFirst; i<=_patternLast; i++) {
+    _hiddenWeight += colorWeight(_palette[getPixelIndex(i)]);
+  }
+}
+
+void PaletteFrame::clearPattern() {
+  markDirty(_patternFirst, _patternLast);
+  _patternFirst = 1;
+  _patternLast = 0;
+  _hiddenWeight = 0;
+}
+
+/************************************************************************************
+ * expand(): the streaming kernel. Writes count pixels, starting at first, as GRB
+ * bytes. The work per pixel is one index fetch and a 3 byte copy. Pixels covered
+ * by the pattern come from the pattern instead. The layers are then blended on,
+ * which only touches the pixels they cover.
+ ************************************************************************************/
+void PaletteFrame::expandIndices(int first, int count, uint8_t *grb) {
+  if (!_scaledValid) {                      // only entries in use need rebuilding
+    for (int i=0; i<kPaletteSize; i++) {
+      if ((_paletteUse[i] != 0) || (i == 0)) {
+        scaleEntry(i);
+      }
+    }
+    _scaledValid = true;
+  }
+  for (int i=first; i<first+count; i++) {
+    const uint8_t *entry = _scaled[getPixelIndex(i)];
+    *grb++ = entry[0];
+    *grb++ = entry[1];
+    *grb++ = entry[2];
+  }
+}
+
+void PaletteFrame::expandLogical(int first, int count, uint8_t *grb) {
+  int last = first + count - 1;
+  if ((_patternFirst > _patternLast) || (_patternFirst > last) || (_patternLast < first)) {
+    expandIndices(first, count, grb);       // no pattern in this range
+  } else {
+    int patternStart = max(first, _patternFirst);
+    int patternEnd = min(last, _patternLast);
+    uint8_t *out = grb;
+    if (patternStart > first) {             // indices before the pattern
+      expandIndices(first, patternStart - first, out);
+      out += 3*(patternStart - first);
+    }
+    _pattern.expand(patternStart - _patternFirst, patternEnd - patternStart + 1, _shownLevel, _dither, out);
+    out += 3*(patternEnd - patternStart + 1);
+    if (patternEnd < last) {                // and after it
+      expandIndices(patternEnd + 1, last - patternEnd, out);
+    }
+  }
+  for (int n=0; n<kFrameLayers; n++) {
+    _layers[n].blend(first, count, grb, _shownLevel, _dither);
+  }
+}
+
+void PaletteFrame::expand(int first, int count, uint8_t *grb) {
+  if (_map == NULL) {
+    expandLogical(first, count, grb);
+  } else {
+    expandMapped(first, count, grb);
+  }
+}
+
+/************************************************************************************
+ * strip order: a run at a time, each expanded in one go; a run going the other way
+ * is then turned round. Gaps between runs are black.
+ ************************************************************************************/
+void PaletteFrame::expandMapped(int first, int count, uint8_t *grb) {
+  int end = first + count;
+  int led = first;
+  for (int r=0; (r<_map->runs()) && (led < end); r++) {
+    const StripRun &aRun = _map->run(r);
+    int stop = min(end, aRun.stripFirst + aRun.count);
+    if (stop <= led) {
+      continue;                             // before the range
+    }
+    if (aRun.stripFirst >= end) {
+      break;
+    }
+    if (aRun.stripFirst > led) {            // gap
+      memset(grb, 0, 3*(aRun.stripFirst - led));
+      grb += 3*(aRun.stripFirst - led);
+      led = aRun.stripFirst;
+    }
+    int length = stop - led;
+    int offset = led - aRun.stripFirst;
+    if (!aRun.reversed) {
+      expandLogical(aRun.logicalFirst + offset, length, grb);
+    } else {
+      expandLogical(aRun.logicalFirst - offset - length + 1, length, grb);
+      for (int i=0, j=length-1; i<j; i++, j--) {     // turn it round
+        for (int c=0; c<3; c++) {
+          uint8_t swap = grb[3*i+c];
+          grb[3*i+c] = grb[3*j+c];
+          grb[3*j+c] = swap;
+        }
+      }
+    }
+    grb += 3*length;
+    led = stop;
+  }
+  if (led < end) {
+    memset(grb, 0, 3*(end - led));
+  }
+}
+
+void PaletteFrame::setPixelMap(PixelMap *map) {
+  _map = map;
+  markAllDirty();
+}
+
+int PaletteFrame::stripPixels() {
+  return (_map == NULL) ? _numPixels : _map->stripPixels();
+}
+
+/************************************************************************************
+ * layers & the dirty range
+ ************************************************************************************/
+FrameLayer &PaletteFrame::layer(int n) {
+  return _layers[constrain(n, 0, kFrameLayers-1)];
+}
+
+void PaletteFrame::markDirty(int first, int last) {
+  first = max(first, 0);
+  last = min(last, _numPixels-1);
+  if (first > last) {
+    return;
+  }
+  if (_dirtyFirst > _dirtyLast) {
+    _dirtyFirst = first;
+    _dirtyLast = last;
+  } else {
+    _dirtyFirst = min(_dirtyFirst, first);
+    _dirtyLast = max(_dirtyLast, last);
+  }
+}
+
+void PaletteFrame::markAllDirty() {
+  _dirtyFirst = 0;
+  _dirtyLast = _numPixels-1;
+}
+
+// kept in logical pixels; reported as the strip LEDs holding them
+bool PaletteFrame::dirtyRange(int &first, int &last) {
+  if ((_map != NULL) && (_dirtyFirst <= _dirtyLast)) {
+    return _map->stripRange(_dirtyFirst, _dirtyLast, first, last);
+  }
+  first = _dirtyFirst;
+  last = _dirtyLast;
+  return first <= last;
+}
+
+// a new output has none of the frame yet
+void PaletteFrame::setOutput(StripOutput *output) {
+  _output = output;
+  markAllDirty();
+}
+
+// the output expands the frame (in whatever pieces suit it) and sends it; the
+// dirty range is what it needs to expand
+void PaletteFrame::show() {
+  PROFILE_ZONE(zoneShow);
+  TRACE_BEGIN(trFrame, 0);
+  limitPower();
+  nextDither();
+  int first, last;
+  for (int n=0; n<kFrameLayers; n++) {
+    if (_layers[n].takeChanged(first, last)) {
+      markDirty(first, last);
+    }
+  }
+  markDirty(_patternFirst, _patternLast);   // a pattern is there to move
+  if (!_scaledValid) {                      // brightness or dither changed
+    markAllDirty();
+  }
+  if (_output != NULL) {
+    _output->show(*this);
+  }
+  TRACE_END(trFrame, 0, _dirtyLast - _dirtyFirst + 1);   // logical pixels sent
+  _dirtyFirst = 1;
+  _dirtyLast = 0;
+}
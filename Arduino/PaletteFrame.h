@@ -0,0 +1,176 @@
+/*!
+ * @file PaletteFrame.h
+ *
+ * @mainpage Arduino library for a palette-indexed NeoPixel frame buffer
+ *
+ * @section intro_sec Introduction
+ *
+ * The animations only ever use a handful of colors at once, so rather
+ * than keeping 3 bytes per LED this class keeps a 4 or 8 bit index per
+ * LED into a small palette of colors. The indices are expanded to the
+ * GRB bytes the strip wants only when the frame is shown.
+ *
+ * The member functions deliberately look like the Adafruit_NeoPixel ones
+ * the animations used to call (setPixelColor, show, setBrightness...) so
+ * an animation draws into the frame exactly as it drew into the strip.
+ *
+ * Palette entries are reference counted. An entry no pixel is using is
+ * free and will be reused for the next new color. Entry 0 is always
+ * black (offColor). If the palette is full, the nearest existing color
+ * is used instead.
+ *
+ * A range of the frame can instead be covered by the frame's periodic
+ * pattern (see PeriodicPattern.h), which is expanded in place of the
+ * indices for those pixels.
+ *
+ * With a power budget set, the frame keeps a running total of the
+ * channel values of all its pixels (updated as pixels change, using the
+ * palette's reference counts; the frame is never scanned) and when it is
+ * shown lowers the brightness just enough to keep the estimated strip
+ * current under the budget. getBrightness() still reports the brightness
+ * asked for.
+ *
+ * Above the pixels (and the pattern) are kFrameLayers layers (see
+ * FrameLayer.h): kOverlayLayer for the PIR indicators and kAlertLayer for
+ * warnings, blended on in that order as the frame is expanded.
+ *
+ * The frame keeps the range of pixels that have changed since it was
+ * last shown: pixels drawn, layers changed, the pattern (assumed to be
+ * moving) and everything when the brightness or dithering changes.
+ * Outputs that keep the last frame (NeoPixel, DotStar, DMA) expand only
+ * that range, and send nothing when it's empty.
+ *
+ * With a PixelMap set (see PixelMap.h) the pixels are drawn in logical
+ * order but expand() and dirtyRange() work in strip order, through the
+ * map's lookup table, so the outputs send the LEDs as they're wired.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PaletteFrame.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "AnimationGlobals.h"
+#include "PeriodicPattern.h"
+#include "FrameLayer.h"
+#include "PixelMap.h"
+#include "FrameSource.h"
+
+#ifndef PaletteFrame_h
+#define PaletteFrame_h
+
+#if (kFrameBitsPerPixel != 4) && (kFrameBitsPerPixel != 8)
+#error "kFrameBitsPerPixel must be 4 or 8"
+#endif
+
+#define kPaletteSize (1 << kFrameBitsPerPixel)                  // # of colors in the palette
+#define kFrameLayers 2                                          // layers above the pixels
+#define kOverlayLayer 0                                         // PIR indicators
+#define kAlertLayer 1                                           // warnings, on top of everything
+#define kFrameBytes ((kNumberOfLEDs*kFrameBitsPerPixel+7)/8)   // bytes of pixel indices
+
+#ifndef kMilliampsPerChannel
+#define kMilliampsPerChannel 20                                 // WS2812 LED at 255, per color
+#endif
+#ifndef kIdleMicroampsPerLED
+#define kIdleMicroampsPerLED 1000                               // WS2812 driver chip, LED off
+#endif
+
+class StripOutput;
+
+/************************************************************************************
+ * A frame of palette indices plus the palette itself
+ * setPixelColor() finds (or adds) the color in the palette and stores its index
+ * show() expands the indices to GRB, applying brightness, and sends them to the strip
+ * brightness is a 16 bit level; the part that 8 bit LEDs can't show is temporally
+ * dithered, the rounding changes a little on every show()
+ * expand() is the streaming kernel used by show(); it writes 3 bytes per pixel
+ ************************************************************************************/
+class PaletteFrame : public FrameSource {
+  public:
+    PaletteFrame(int numPixels);
+    void begin();                           // all pixels black, palette emptied
+    void show();                            // send the frame to the output, which expands it
+    void setOutput(StripOutput *output);    // where show() sends frames; NULL -> nowhere
+    void setPixelColor(int i, uint32_t aColor);
+    uint32_t getPixelColor(int i);
+    void fill(uint32_t aColor, int first=0, int count=0);   // count==0 -> to end of strip
+    void setBrightness(uint8_t brightness); // applied at expansion; the palette keeps full colors
+    uint8_t getBrightness();
+    void setBrightnessLevel(uint16_t level);  // finer control, 0..65535, dithered over frames
+    uint16_t getBrightnessLevel();
+    void setPowerBudget(uint16_t milliamps);  // 0 -> no limit
+    uint32_t estimatedMilliamps();          // at the brightness being shown
+    uint16_t shownLevel();                  // brightness actually shown (<= level when limited)
+    int numPixels();
+
+    int paletteIndex(uint32_t aColor);      // find or add aColor; claimed by the next setPixelIndex
+    void setPixelIndex(int i, uint8_t idx); // cheapest possible write
+    uint8_t getPixelIndex(int i);
+    void expand(int first, int count, uint8_t *grb);    // streaming expansion to GRB bytes, strip order
+    void setPixelMap(PixelMap *map);        // how the strip is wired; NULL -> in logical order
+    int stripPixels();                      // LEDs the outputs send
+
+    PeriodicPattern &pattern();             // the one pattern the frame can show
+    void usePattern(int first, int last);   // pattern replaces pixels first..last when shown
+    void clearPattern();                    // back to the pixel indices
+
+    FrameLayer &layer(int n);               // kOverlayLayer or kAlertLayer
+    bool dirtyRange(int &first, int &last); // strip LEDs changed since last shown; false if none
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b);
+
+  private:
+    int _numPixels;                         // # of pixels actually in use (<= kNumberOfLEDs)
+    uint8_t _indices[kFrameBytes];          // palette index per pixel, packed
+    uint32_t _palette[kPaletteSize];        // colors, 0x00RRGGBB just like pixels.Color()
+    uint16_t _paletteUse[kPaletteSize];     // # of pixels using each palette entry
+    uint8_t _scaled[kPaletteSize][3];       // palette with brightness applied, GRB order
+    bool _scaledValid;                      // false -> _scaled needs rebuilding
+    uint16_t _level;                        // brightness asked for, 0..65535
+    uint16_t _shownLevel;                   // brightness after the power limit
+    uint16_t _powerBudget;                  // milliamps, 0 -> none
+    uint32_t _weightSum;                    // colorWeight() summed over all pixels
+    uint32_t _hiddenWeight;                 // the part of that covered by the pattern
+    uint16_t _dither;                       // rounding offset for this show()
+    uint8_t _lastIndex;                     // last index found by paletteIndex(), runs are common
+    StripOutput *_output;                   // where show() sends frames
+    PeriodicPattern _pattern;
+    int _patternFirst;                      // pixels covered by the pattern,
+    int _patternLast;                       // _patternFirst > _patternLast -> none
+    FrameLayer _layers[kFrameLayers];
+    int _dirtyFirst;                        // pixels changed since last shown,
+    int _dirtyLast;                         // _dirtyFirst > _dirtyLast -> none
+    PixelMap *_map;                         // NULL -> strip order is logical order
+
+    void expandLogical(int first, int count, uint8_t *grb);
+    void expandMapped(int first, int count, uint8_t *grb);
+    void expandIndices(int first, int count, uint8_t *grb);
+    void markDirty(int first, int last);
+    void markAllDirty();
+
+    void scaleEntry(int idx);               // rebuild one _scaled entry
+    void nextDither();                      // step _dither for the next show()
+    void limitPower();                      // work out _shownLevel
+    uint32_t fullMilliamps();               // current of the lit LEDs at full brightness
+    void changeWeight(int i, uint8_t old, uint8_t idx);
+    int nearestIndex(uint32_t aColor);      // used when the palette is full
+};
+
+#endif
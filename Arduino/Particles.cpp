@@ -0,0 +1,247 @@
+/*!
+ * @file Particles.cpp
+ *
+ * @mainpage Arduino library for moving "particles" along a NeoPixel strip
+ *
+ * @section intro_sec Introduction
+ *
+ * ParticleEngine moves lit pixels along the strip using fixed point
+ * positions and velocities, rewriting only the pixels that change.
+ * Walkers is a preset with many particles.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Particles.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "Particles.h"
+#include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+
+#define maxElapsed 1000           // cap on one update (ms) so a long stall can't overflow positions
+
+/************************************************************************************
+ * moves particles along the strip, only touching pixels that change
+ ************************************************************************************/
+ParticleEngine::ParticleEngine(const char * animationName, float animationTime, int firstOffset, int lastOffset):Animation(animationName, animationTime, firstOffset, lastOffset) {
+  if (_animationTime > 0) {           // one trip along the strip in _animationTime seconds
+    _speed = long(65536.0 * (_lastLED - _firstLED) / (_animationTime * 1000));
+  } else {                            // or one pixel every _animationStepIncrement ms
+    _speed = 65536L / max(_animationStepIncrement, 1);
+  }
+  _maxPosition = 0;                   // set by Start(), setSegment() may move _lastLED
+  _particles = NULL;
+  _particleCount = 0;
+  _inverse = false;
+  _background = offColor;
+  _headColor = offColor;
+}
+
+// add a particle at pixel, heading in direction (+1/-1); returns its index or -1 if we're full
+int ParticleEngine::addParticle(int pixel, int direction, uint32_t color, int trail, int edgeRule, int speedPercent) {
+  if (_particleCount >= kMaxParticles) {
+    return -1;
+  }
+  Particle &p = _particles[_particleCount];
+  p.position = long(constrain(pixel, _firstLED, _lastLED) - _firstLED) << 16;
+  p.velocity = _speed * speedPercent / 100;
+  if (direction < 0) {
+    p.velocity = -p.velocity;
+  }
+  p.color = color;
+  p.trail = trail;
+  p.edgeRule = edgeRule;
+  p.drawnHead = -1;
+  p.drawnDirection = direction;
+  return _particleCount++;
+}
+
+// default is no particles at all; presets override this
+void ParticleEngine::addParticles() {
+}
+
+// default is to do nothing when a particle moves to a new pixel
+void ParticleEngine::particleStepped(int p) {
+  (void)p;                                  // compiler happiness
+}
+
+// start up the animation
+void ParticleEngine::Start(bool topToBottom, uint32_t colorToUse) {
+  _topToBottom = topToBottom;
+  _colorToUse = colorToUse;
+  ParticleState *state = (ParticleState *)claimState(sizeof(ParticleState));
+  _active = state != NULL;
+  if (!_active) {
+    return;
+  }
+  _particles = state->particles;
+  _particleCount = 0;
+  _maxPosition = long(_lastLED - _firstLED) << 16;
+  _background = (_inverse) ? _colorToUse : offColor;  // inverse presets light the strip
+  _headColor = (_inverse) ? offColor : _colorToUse;   // and move dark particles
+  frame.setBrightness(mappedBrightness());  // use a dim version of whatever color
+  setAllPixelsTo(_background, false);
+  addParticles();
+  drawParticles(true);
+  frame.show();
+  _lastUpdateTime = animationMillis();      // we've done first step here
+}
+
+// advance one particle by elapsed milliseconds, applying its edge rule
+void ParticleEngine::moveParticle(Particle &p, unsigned long elapsed) {
+  p.position += p.velocity * long(elapsed);
+  if (_maxPosition <= 0) {                  // one pixel strip, nowhere to go
+    p.position = 0;
+    return;
+  }
+  if (p.edgeRule == particleWrap) {
+    long length = _maxPosition + 65536L;
+    p.position %= length;
+    if (p.position < 0) {
+      p.position += length;
+    }
+    return;
+  }
+  while ((p.position < 0) || (p.position > _maxPosition)) {   // bounce, reflecting any overshoot
+    if (p.position > _maxPosition) {
+      p.position = 2*_maxPosition - p.position;
+    } else {
+      p.position = -p.position;
+    }
+    p.velocity = -p.velocity;
+  }
+}
+
+// keep the animation going until completed
+void ParticleEngine::Continue() {
+  if (!_active) {                           // nothing to do here if we're not active
+    return;
+  }
+  if (!holdsState()) {                      // another animation has the arena
+    _active = false;
+    return;
+  }
+  unsigned long now = animationMillis();
+  unsigned long elapsed = now - _lastUpdateTime;
+  if (elapsed == 0) {                       // positions are per millisecond
+    return;
+  }
+  if (elapsed > maxElapsed) {
+    elapsed = maxElapsed;
+  }
+  for (int i=0; i<_particleCount; i++) {
+    Particle &p = _particles[i];
+    moveParticle(p, elapsed);
+    if (_firstLED + int(p.position >> 16) != p.drawnHead) {
+      particleStepped(i);
+    }
+  }
+  if (drawParticles(false)) {               // only show if a particle changed pixels
+    frame.show();
+  }
+  _lastUpdateTime = now;
+}
+
+// draw (or erase) one particle with its head at pixel head
+void ParticleEngine::drawParticle(const Particle &p, int head, int direction, bool erase) {
+  int span = _lastLED - _firstLED + 1;
+  for (int k=0; k<=p.trail; k++) {
+    int pixel = head - k*direction;
+    if ((pixel < _firstLED) || (pixel > _lastLED)) {
+      if (p.edgeRule != particleWrap) {
+        continue;                           // trail runs off the end
+      }
+      pixel = (pixel < _firstLED) ? pixel + span : pixel - span;
+    }
+    uint32_t aColor = _background;
+    if (!erase) {
+      aColor = p.color;
+      if (k > 0) {                          // trail fades out behind the head
+        uint32_t fraction = p.trail + 1 - k;
+        uint32_t steps = p.trail + 1;
+        aColor = rgbColor(((p.color >> 16) & 0xFF) * fraction / steps,
+                          ((p.color >> 8) & 0xFF) * fraction / steps,
+                          (p.color & 0xFF) * fraction / steps);
+      }
+    }
+    frame.setPixelColor(pixel, aColor);
+  }
+}
+
+// erase particles that moved, then draw everything; overlapping particles that
+// were erased by a neighbour moving are simply drawn again
+bool ParticleEngine::drawParticles(bool force) {
+  bool changed = force;
+  for (int i=0; i<_particleCount; i++) {
+    Particle &p = _particles[i];
+    int head = _firstLED + int(p.position >> 16);
+    int direction = (p.velocity < 0) ? -1 : 1;
+    if ((head != p.drawnHead) || (direction != p.drawnDirection)) {
+      if (p.drawnHead >= 0) {
+        drawParticle(p, p.drawnHead, p.drawnDirection, true);
+      }
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return false;
+  }
+  for (int i=0; i<_particleCount; i++) {
+    Particle &p = _particles[i];
+    p.drawnHead = _firstLED + int(p.position >> 16);
+    p.drawnDirection = (p.velocity < 0) ? -1 : 1;
+    drawParticle(p, p.drawnHead, p.drawnDirection, false);
+  }
+  return true;
+}
+
+// simple, just set pixels black, restore brightness & stop
+void ParticleEngine::Finish(bool topToBottom) {
+  _topToBottom = topToBottom;
+  _active = false;
+  _particleCount = 0;
+  releaseState();
+  setAllPixelsTo(offColor, false);
+  frame.setBrightness(255);
+  frame.show();
+}
+
+void ParticleEngine::printSelf() {
+  Serial.print(_name); Serial.print(": "); Serial.print(_particleCount); Serial.print(" particles, ");
+  Serial.println(_speed);
+}
+
+/************************************************************************************
+ * lots of particles at random places, speeds and colors, each with a short trail
+ ************************************************************************************/
+Walkers::Walkers(const char * animationName, float animationTime, int walkerCount, int firstOffset, int lastOffset):ParticleEngine(animationName, animationTime, firstOffset, lastOffset) {
+  _walkerCount = min(walkerCount, kMaxParticles);
+}
+
+void Walkers::addParticles() {
+  for (int i=0; i<_walkerCount; i++) {
+    int direction = (random(2) == 0) ? -1 : 1;
+    addParticle(random(_firstLED, _lastLED+1), direction, randomColor(), 2, particleBounce, random(50, 151));
+  }
+}
+
+void Walkers::printSelf() {
+  Serial.print("Walkers "); Serial.println(_walkerCount);
+}
@@ -0,0 +1,111 @@
+/*!
+ * @file Particles.h
+ *
+ * @mainpage Arduino library for moving "particles" along a NeoPixel strip
+ *
+ * @section intro_sec Introduction
+ *
+ * ParticleEngine is derived from Animation and moves up to kMaxParticles
+ * lit pixels (particles) along the strip. Each particle has a position,
+ * a velocity, a color, an optional fading trail and a rule for what
+ * happens at the ends of the strip (bounce or wrap).
+ *
+ * Positions are 16.16 fixed point pixels and velocities are fixed point
+ * pixels per millisecond, so motion is smooth whatever the strip length
+ * and however often Continue() happens to be called. Only the pixels a
+ * particle leaves or enters are rewritten.
+ *
+ * The ZipLine family (ZipLine.h) are presets of this engine.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Particles.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "Animation.h"
+
+#ifndef Particles_h
+#define Particles_h
+
+#define kMaxParticles 12          // most particles one engine will move
+#define particleBounce 0          // reverse direction at the ends of the strip
+#define particleWrap 1            // leave one end, reappear at the other
+
+struct Particle {
+  long position;                  // 16.16 fixed point, pixels from _firstLED
+  long velocity;                  // 16.16 fixed point pixels per millisecond
+  uint32_t color;                 // color of the head
+  uint8_t trail;                  // # of fading pixels behind the head
+  uint8_t edgeRule;               // particleBounce or particleWrap
+  int drawnHead;                  // pixel drawn last time, -1 if none
+  int drawnDirection;             // direction it was heading then
+};
+
+struct ParticleState {            // working state, in the animation arena while active
+  Particle particles[kMaxParticles];
+};
+
+/************************************************************************************
+ * moves particles along the strip, only touching pixels that change
+ * derived classes add particles in addParticles() and may react as each particle moves
+ * on to a new pixel by overriding particleStepped()
+ ************************************************************************************/
+class ParticleEngine : public Animation {
+  public:
+    ParticleEngine(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
+    void Start(bool topToBottom, uint32_t colorToUse);
+    void Continue();
+    void Finish(bool topToBottom);
+    void printSelf();
+
+  protected:
+    Particle *_particles;         // ParticleState's, while active
+    int _particleCount;
+    uint32_t _background;         // color of pixels without a particle
+    long _speed;                  // 16.16 pixels/millisecond for one trip in _animationTime
+    bool _inverse;                // true -> light the strip and move dark particles
+    uint32_t _headColor;          // color for particles, set up by Start()
+
+    virtual void addParticles();            // called by Start() to populate _particles
+    virtual void particleStepped(int p);    // particle p just moved to a new pixel
+    int addParticle(int pixel, int direction, uint32_t color, int trail=0, int edgeRule=particleBounce, int speedPercent=100);
+    bool drawParticles(bool force);         // erase & redraw particles that moved; true if anything changed
+
+  private:
+    long _maxPosition;            // last pixel of the segment, 16.16; set by Start()
+    void moveParticle(Particle &p, unsigned long elapsed);
+    void drawParticle(const Particle &p, int head, int direction, bool erase);
+};
+
+/************************************************************************************
+ * lots of particles at random places, speeds and colors, each with a short trail
+ ************************************************************************************/
+class Walkers : public ParticleEngine {
+  public:
+    Walkers(const char * animationName, float animationTime, int walkerCount, int firstOffset=1, int lastOffset=-1);
+    void printSelf();
+
+  protected:
+    void addParticles();
+
+  private:
+    int _walkerCount;
+};
+
+#endif
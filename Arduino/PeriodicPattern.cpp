@@ -0,0 +1,114 @@
+/*!
+ * @file PeriodicPattern.cpp
+ *
+ * @mainpage Arduino library for patterns that repeat along a NeoPixel strip
+ *
+ * @section intro_sec Introduction
+ *
+ * Stores one period of a repeating pattern and a phase. expand() is
+ * called by the frame when it is shown.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PeriodicPattern.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "PeriodicPattern.h"
+#include "AnimationGlobals.h"
+
+PeriodicPattern::PeriodicPattern() {
+  memset(_colors, 0, sizeof(_colors));
+  setPeriod(1);
+}
+
+void PeriodicPattern::setPeriod(int period, int stride) {
+  _period = constrain(period, 1, kMaxPatternPeriod);
+  _stride = stride;
+  _phase = 0;
+  _scaledValid = false;
+  _weightSum = 0;
+  for (int i=0; i<_period; i++) {
+    _weightSum += colorWeight(_colors[i]);
+  }
+}
+
+int PeriodicPattern::period() {
+  return _period;
+}
+
+void PeriodicPattern::setEntry(int i, uint32_t aColor) {
+  if ((i < 0) || (i >= _period)) {
+    return;
+  }
+  _weightSum += colorWeight(aColor) - colorWeight(_colors[i]);
+  _colors[i] = aColor;
+  _scaledValid = false;
+}
+
+void PeriodicPattern::setPhase(long phase) {
+  long length = long(_period) << 8;
+  _phase = phase % length;
+  if (_phase < 0) {
+    _phase += length;
+  }
+}
+
+// this is the whole cost of moving the pattern
+void PeriodicPattern::advance(long delta) {
+  setPhase(_phase + delta);
+}
+
+uint32_t PeriodicPattern::colorAt(int offset) {
+  long position = (_phase + offset*_stride) >> 8;
+  return _colors[position % _period];
+}
+
+// whole periods exactly, the part period as an average
+uint32_t PeriodicPattern::weight(int count) {
+  return uint32_t((uint64_t(_weightSum) * count) / _period);
+}
+
+/************************************************************************************
+ * expand(): write count pixels, starting offset pixels into the pattern, as GRB
+ * bytes. The position is stepped rather than divided for each pixel since the
+ * M0 has no divide instruction.
+ ************************************************************************************/
+void PeriodicPattern::expand(int offset, int count, uint16_t level, uint16_t dither, uint8_t *grb) {
+  if (!_scaledValid || (_scaledLevel != level) || (_scaledDither != dither)) {
+    for (int i=0; i<_period; i++) {
+      scaleColorToGRB(_colors[i], level, dither, _scaled[i]);
+    }
+    _scaledLevel = level;
+    _scaledDither = dither;
+    _scaledValid = true;
+  }
+  long length = long(_period) << 8;
+  long position = (_phase + long(offset)*_stride) % length;
+  for (int i=0; i<count; i++) {
+    const uint8_t *entry = _scaled[position >> 8];
+    *grb++ = entry[0];
+    *grb++ = entry[1];
+    *grb++ = entry[2];
+    position += _stride;
+    while (position >= length) {
+      position -= length;
+    }
+  }
+}
@@ -0,0 +1,72 @@
+/*!
+ * @file PeriodicPattern.h
+ *
+ * @mainpage Arduino library for patterns that repeat along a NeoPixel strip
+ *
+ * @section intro_sec Introduction
+ *
+ * Marquee lights, rainbows and the like are one short period of colors
+ * repeated (or stretched) along the strip and shifted a little at each
+ * step. PeriodicPattern stores just that one period plus a phase. The
+ * frame expands it when it is shown, so moving the pattern is a change
+ * of phase rather than a rewrite of every pixel.
+ *
+ * The phase and the stride (how far through the period each pixel moves)
+ * are 8.8 fixed point entries. A stride of 256 is one entry per pixel;
+ * smaller strides stretch the period over more pixels.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PeriodicPattern.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef PeriodicPattern_h
+#define PeriodicPattern_h
+
+#define kMaxPatternPeriod 64      // most entries in one period
+
+/************************************************************************************
+ * one period of colors and a phase; expand() writes pixels as GRB bytes
+ ************************************************************************************/
+class PeriodicPattern {
+  public:
+    PeriodicPattern();
+    void setPeriod(int period, int stride=256);   // # entries, 8.8 entries per pixel
+    void setEntry(int i, uint32_t aColor);
+    void setPhase(long phase);                    // 8.8 entries, any value (wrapped)
+    void advance(long delta);                     // move the pattern along
+    int period();
+    uint32_t colorAt(int offset);                 // color of pixel offset from the start
+    uint32_t weight(int count);                   // ~ sum of colorWeight() over count pixels
+    void expand(int offset, int count, uint16_t level, uint16_t dither, uint8_t *grb);
+
+  private:
+    uint32_t _colors[kMaxPatternPeriod];
+    uint8_t _scaled[kMaxPatternPeriod][3];        // _colors with brightness applied, GRB order
+    bool _scaledValid;                            // false -> _scaled needs rebuilding
+    uint16_t _scaledLevel;                        // brightness level _scaled was built for
+    uint16_t _scaledDither;                       // and the dither
+    int _period;
+    uint32_t _weightSum;                          // colorWeight() of one period
+    long _stride;
+    long _phase;                                  // always 0.._period<<8
+};
+
+#endif
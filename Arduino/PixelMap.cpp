@@ -0,0 +1,129 @@
+/*!
+ * @file PixelMap.cpp
+ *
+ * @mainpage Arduino library for strips not wired in step order
+ *
+ * @section intro_sec Introduction
+ *
+ * Building the lookup tables. See PixelMap.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PixelMap.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "PixelMap.h"
+
+PixelMap::PixelMap() {
+  _runCount = 0;
+  _stripPixels = 0;
+  _identity = true;
+}
+
+// on failure the map is left as the identity
+bool PixelMap::begin(const PixelRun *runs, int count, int stripPixels) {
+  _stripPixels = constrain(stripPixels, 0, kNumberOfLEDs);
+  for (int i=0; i<kNumberOfLEDs; i++) {
+    _toLogical[i] = kNoPixel;
+    _toStrip[i] = kNoPixel;
+  }
+  bool ok = (count <= kMaxPixelRuns);
+  _runCount = 0;
+  for (int r=0; (r<count) && ok; r++) {
+    const PixelRun &aRun = runs[r];
+    for (int n=0; n<aRun.count; n++) {
+      int pixel = aRun.logicalFirst + n;
+      int led = aRun.reversed ? aRun.stripFirst - n : aRun.stripFirst + n;
+      if ((pixel < 0) || (pixel >= kNumberOfLEDs) || (led < 0) || (led >= _stripPixels) ||
+          (_toLogical[led] != kNoPixel) || (_toStrip[pixel] != kNoPixel)) {
+        ok = false;
+        break;
+      }
+      _toLogical[led] = pixel;
+      _toStrip[pixel] = led;
+    }
+    if (ok && (aRun.count > 0)) {           // insertion sort by where they start on the strip
+      StripRun aStripRun;
+      aStripRun.stripFirst = aRun.reversed ? aRun.stripFirst - aRun.count + 1 : aRun.stripFirst;
+      aStripRun.count = aRun.count;
+      aStripRun.logicalFirst = aRun.reversed ? aRun.logicalFirst + aRun.count - 1 : aRun.logicalFirst;
+      aStripRun.reversed = aRun.reversed;
+      int n = _runCount++;
+      while ((n > 0) && (_runs[n-1].stripFirst > aStripRun.stripFirst)) {
+        _runs[n] = _runs[n-1];
+        n -= 1;
+      }
+      _runs[n] = aStripRun;
+    }
+  }
+  _identity = true;
+  for (int i=0; i<_stripPixels; i++) {
+    if (!ok) {
+      _toLogical[i] = i;
+      _toStrip[i] = i;
+    } else if (_toLogical[i] != i) {
+      _identity = false;
+    }
+  }
+  if (!ok) {
+    _runs[0].stripFirst = 0;
+    _runs[0].count = _stripPixels;
+    _runs[0].logicalFirst = 0;
+    _runs[0].reversed = false;
+    _runCount = 1;
+  }
+  return ok;
+}
+
+bool PixelMap::identity() {
+  return _identity;
+}
+
+int PixelMap::stripPixels() {
+  return _stripPixels;
+}
+
+uint16_t PixelMap::logical(int led) {
+  return ((led >= 0) && (led < _stripPixels)) ? _toLogical[led] : kNoPixel;
+}
+
+uint16_t PixelMap::strip(int pixel) {
+  return ((pixel >= 0) && (pixel < kNumberOfLEDs)) ? _toStrip[pixel] : kNoPixel;
+}
+
+bool PixelMap::stripRange(int first, int last, int &stripFirst, int &stripLast) {
+  stripFirst = _stripPixels;
+  stripLast = -1;
+  for (int i=max(first, 0); i<=min(last, kNumberOfLEDs-1); i++) {
+    uint16_t led = _toStrip[i];
+    if (led != kNoPixel) {
+      stripFirst = min(stripFirst, int(led));
+      stripLast = max(stripLast, int(led));
+    }
+  }
+  return stripFirst <= stripLast;
+}
+
+int PixelMap::runs() {
+  return _runCount;
+}
+
+const StripRun &PixelMap::run(int n) {
+  return _runs[n];
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file PixelMap.h
+ *
+ * @mainpage Arduino library for strips not wired in step order
+ *
+ * @section intro_sec Introduction
+ *
+ * The animations draw into the frame in logical order: pixel 0 at the
+ * bottom of the stairs, the last one at the top, no gaps. Real strips
+ * are fed from the middle, have sections running the other way, and
+ * have LEDs under a landing that should stay dark. A PixelMap describes
+ * the wiring as runs of logical pixels and where each run is on the
+ * strip (and which way round), and is turned into lookup tables once, at
+ * boot, along with the runs sorted into strip order. The frame then
+ * expands itself in strip order a run at a time (see
+ * PaletteFrame::setPixelMap()), turning round the runs that go the
+ * other way, and the animations never know.
+ *
+ * Strip LEDs no run covers are sent black.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * PixelMap.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "AnimationGlobals.h"
+
+#ifndef PixelMap_h
+#define PixelMap_h
+
+#define kNoPixel 0xFFFF                   // a strip LED with no logical pixel, or vice versa
+#define kMaxPixelRuns 16
+
+struct PixelRun {
+  int16_t logicalFirst;
+  int16_t count;
+  int16_t stripFirst;                     // strip LED of logicalFirst
+  bool reversed;                          // true -> the run goes down the strip from stripFirst
+};
+
+// a run as the strip sees it: logicalFirst is the pixel at stripFirst
+struct StripRun {
+  int16_t stripFirst;
+  int16_t count;
+  int16_t logicalFirst;
+  bool reversed;                          // true -> logical pixels go down as the strip goes up
+};
+
+/************************************************************************************
+ * begin() once with the runs; logical() & strip() are the tables
+ ************************************************************************************/
+class PixelMap {
+  public:
+    PixelMap();
+    bool begin(const PixelRun *runs, int count, int stripPixels);  // false if runs are off the strip, overlap or too many
+    bool identity();                        // logical order is strip order, no gaps
+    int stripPixels();
+    uint16_t logical(int led);              // strip LED -> logical pixel, kNoPixel for a gap
+    uint16_t strip(int pixel);              // logical pixel -> strip LED, kNoPixel if not on the strip
+    bool stripRange(int first, int last, int &stripFirst, int &stripLast);  // LEDs holding logical first..last
+    int runs();
+    const StripRun &run(int n);             // in strip order
+
+  private:
+    uint16_t _toLogical[kNumberOfLEDs];
+    uint16_t _toStrip[kNumberOfLEDs];
+    StripRun _runs[kMaxPixelRuns];
+    int _runCount;
+    int _stripPixels;
+    bool _identity;
+};
+
+#endif
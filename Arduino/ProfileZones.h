@@ -0,0 +1,40 @@
+/*!
+ * @file ProfileZones.h
+ *
+ * @mainpage The parts of loop() Profiler can time
+ *
+ * @section intro_sec Introduction
+ *
+ * One PROFILE_ZONE_ENTRY(name, "text") per zone. The position in the
+ * list is the zone's index in the profile table; the text is what
+ * Profiler::print() shows for it.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * ProfileZones.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+// no include guard: included more than once with different PROFILE_ZONE_ENTRY definitions
+
+PROFILE_ZONE_ENTRY(zoneLoop, "loop()")
+PROFILE_ZONE_ENTRY(zoneLightLevel, "getLightLevel()")
+PROFILE_ZONE_ENTRY(zonePIRRead, "PIR::read()")
+PROFILE_ZONE_ENTRY(zoneStateMachine, "executeStateMachine()")
+PROFILE_ZONE_ENTRY(zoneContinue, "animation Continue()")
+PROFILE_ZONE_ENTRY(zoneShow, "PaletteFrame::show()")
+PROFILE_ZONE_ENTRY(zoneLogDrain, "eventLog.drain()")
@@ -0,0 +1,117 @@
+/*!
+ * @file Profiler.cpp
+ *
+ * @mainpage Arduino library for timing the hot parts of loop()
+ *
+ * @section intro_sec Introduction
+ *
+ * The profile table and the cycle counters for SAMD21, SAMD51 and the
+ * host. Nothing here is compiled unless kProfiling is 1.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Profiler.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "Profiler.h"
+
+#if kProfiling
+
+#if !defined(ARDUINO_ARCH_SAMD)
+#include <chrono>
+#endif
+
+Profiler profiler;
+
+#define PROFILE_ZONE_ENTRY(name, text) text,
+static const char * const zoneNames[zoneCount] = {
+#include "ProfileZones.h"
+};
+#undef PROFILE_ZONE_ENTRY
+
+Profiler::Profiler() {
+  reset();
+}
+
+void Profiler::reset() {
+  memset(_zones, 0, sizeof(_zones));
+}
+
+#if defined(__SAMD51__)
+// the DWT cycle counter is there on the M4, but off until the trace unit is enabled
+void Profiler::begin() {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  reset();
+}
+
+uint32_t Profiler::ticks() {
+  return DWT->CYCCNT;
+}
+#elif defined(ARDUINO_ARCH_SAMD)
+void Profiler::begin() {
+  reset();
+}
+
+// the M0 has no cycle counter; SysTick counts down from LOAD every millisecond,
+// so the cycles are millis() of whole ones plus how far into this one it is.
+// With interrupts off SysTick can wrap without millis() moving on; its interrupt
+// is then pending, and that millisecond is added here
+uint32_t Profiler::ticks() {
+  uint32_t ms;
+  uint32_t count;
+  uint32_t pending;
+  do {
+    ms = millis();
+    count = SysTick->VAL;
+    pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) ? 1 : 0;
+    if (pending) {
+      count = SysTick->VAL;               // it may have wrapped after the first read
+    }
+  } while (ms != millis());               // the millisecond turned over meanwhile
+  uint32_t reload = SysTick->LOAD + 1;
+  return (ms + pending) * reload + (reload - 1 - count);
+}
+#else
+void Profiler::begin() {
+  reset();
+}
+
+// the real time it takes here, not the virtual clock's
+uint32_t Profiler::ticks() {
+  return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#endif
+
+void Profiler::print(Print &out) {
+  out.println("profile: zone, count, total us, mean us, longest us");
+  for (int z=0; z<zoneCount; z++) {
+    ZoneStats &stats = _zones[z];
+    out.print(zoneNames[z]); out.print(", ");
+    out.print(stats.count); out.print(", ");
+    out.print((unsigned long)(stats.total / kProfileTicksPerMicro)); out.print(", ");
+    out.print((stats.count == 0) ? 0.0 : double(stats.total) / stats.count / kProfileTicksPerMicro, 1);
+    out.print(", ");
+    out.println(double(stats.longest) / kProfileTicksPerMicro, 1);
+  }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*!
+ * @file Profiler.h
+ *
+ * @mainpage Arduino library for timing the hot parts of loop()
+ *
+ * @section intro_sec Introduction
+ *
+ * PROFILE_ZONE(zone) at the top of a block times the rest of the block;
+ * PROFILE_ENTER(zone) & PROFILE_EXIT(zone) time what's between them. The
+ * zones are listed in ProfileZones.h. Each zone's count of entries, total
+ * and longest time are kept in a small static table; profiler.print()
+ * sends it to Serial as text (decodeLog.py passes text through), and
+ * reset() starts again. A zone's time includes any zones inside it.
+ *
+ * Times are processor cycles where they can be had cheaply:
+ *  - SAMD51 (Cortex-M4): the DWT cycle counter
+ *  - SAMD21 (Cortex-M0, no DWT): SysTick, which counts down the cycles of
+ *    each millisecond, plus millis() for the milliseconds
+ *  - host: std::chrono::steady_clock, in nanoseconds
+ * Entering and leaving a zone costs a counter read each and a few adds.
+ *
+ * Set kProfiling to 1 to use it; at 0 the macros compile to nothing and
+ * there is no table.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Profiler.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#ifndef kProfiling
+#define kProfiling 0                      // 1 -> PROFILE_ZONE() etc. time their zones
+#endif
+
+#if defined(ARDUINO_ARCH_SAMD)
+#define kProfileTicksPerMicro (F_CPU / 1000000)   // cycles
+#else
+#define kProfileTicksPerMicro 1000                // host: nanoseconds
+#endif
+
+// zone ids, in ProfileZones.h order
+#define PROFILE_ZONE_ENTRY(name, text) name,
+enum ProfileZone {
+#include "ProfileZones.h"
+  zoneCount
+};
+#undef PROFILE_ZONE_ENTRY
+
+struct ZoneStats {
+  uint32_t count;                         // times the zone was left
+  uint64_t total;                         // ticks
+  uint32_t longest;
+};
+
+/************************************************************************************
+ * one global instance, profiler; begin() once, then use it through the macros
+ ************************************************************************************/
+class Profiler {
+  public:
+    Profiler();
+    void begin();                         // start the counter (DWT needs turning on)
+    void add(ProfileZone zone, uint32_t ticks) {  // inline: it's in every zone's exit
+      ZoneStats &stats = _zones[zone];
+      stats.count += 1;
+      stats.total += ticks;
+      if (ticks > stats.longest) {
+        stats.longest = ticks;
+      }
+    }
+    void print(Print &out);               // a line per zone: count, total, mean & longest us
+    void reset();
+    static uint32_t ticks();              // free running; differences are good for a while
+
+  private:
+    ZoneStats _zones[zoneCount];
+};
+
+// times from construction to the end of its scope
+class ProfileScope {
+  public:
+    ProfileScope(ProfileZone zone);
+    ~ProfileScope();
+
+  private:
+    ProfileZone _zone;
+    uint32_t _start;
+};
+
+#if kProfiling
+extern Profiler profiler;
+
+inline ProfileScope::ProfileScope(ProfileZone zone) : _zone(zone), _start(Profiler::ticks()) {
+}
+
+inline ProfileScope::~ProfileScope() {
+  profiler.add(_zone, Profiler::ticks() - _start);
+}
+
+#define PROFILE_ZONE(zone) ProfileScope profileScope_##zone(zone)
+#define PROFILE_ENTER(zone) uint32_t profileStart_##zone = Profiler::ticks()
+#define PROFILE_EXIT(zone) profiler.add((zone), Profiler::ticks() - profileStart_##zone)
+#else
+#define PROFILE_ZONE(zone) do { } while (0)
+#define PROFILE_ENTER(zone) do { } while (0)
+#define PROFILE_EXIT(zone) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,231 @@
+/*!
+ * @file RenderAhead.cpp
+ *
+ * @mainpage Arduino library for frames prepared ahead of the time they're shown
+ *
+ * @section intro_sec Introduction
+ *
+ * A ring of expanded frames, filled by running an animation ahead of the
+ * clock and emptied on time into the real output.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * RenderAhead.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "RenderAhead.h"
+#include "TraceLog.h"
+
+// grow first..last (first > last -> empty) to take in aFirst..aLast
+static void widenRange(int &first, int &last, int aFirst, int aLast) {
+  if (aFirst > aLast) {
+    return;
+  }
+  if (first > last) {
+    first = aFirst;
+    last = aLast;
+    return;
+  }
+  first = min(first, aFirst);
+  last = max(last, aLast);
+}
+
+/************************************************************************************
+ * PreparedFrame: everything is already in bytes[]
+ ************************************************************************************/
+bool PreparedFrame::dirtyRange(int &first, int &last) {
+  first = changedFirst;
+  last = min(changedLast, pixels-1);
+  return first <= last;
+}
+
+void PreparedFrame::expand(int first, int count, uint8_t *grb) {
+  memcpy(grb, bytes + 3*first, 3*count);
+}
+
+int PreparedFrame::stripPixels() {
+  return pixels;
+}
+
+/************************************************************************************
+ * RenderAhead
+ ************************************************************************************/
+RenderAhead::RenderAhead(StripOutput &output) : _output(output) {
+  _head = 0;
+  _count = 0;
+  _unsentFirst = 1;
+  _unsentLast = 0;
+  _rendering = false;
+  _renderTime = 0;
+  _renderedTo = 0;
+  _capturedFirst = 1;
+  _capturedLast = 0;
+  _framesSent = 0;
+  _framesSkipped = 0;
+  _framesDiscarded = 0;
+  memset(_lateness, 0, sizeof(_lateness));
+  _maxLateness = 0;
+}
+
+void RenderAhead::begin() {
+  memset(_latest.bytes, 0, sizeof(_latest.bytes));
+  _latest.pixels = 0;
+  _output.begin();
+}
+
+bool RenderAhead::ready() {
+  return _output.ready();
+}
+
+unsigned long RenderAhead::clock() {
+  return _rendering ? _renderTime : millis();
+}
+
+bool RenderAhead::idle() {
+  return _count == 0;
+}
+
+// only the LEDs aFrame says have changed are expanded; _latest has the rest
+void RenderAhead::capture(FrameSource &aFrame, int &first, int &last) {
+  _latest.pixels = min(aFrame.stripPixels(), kNumberOfLEDs);
+  int dirtyFirst, dirtyLast;
+  if (!aFrame.dirtyRange(dirtyFirst, dirtyLast) || (dirtyFirst >= _latest.pixels)) {
+    return;
+  }
+  dirtyLast = min(dirtyLast, _latest.pixels-1);
+  aFrame.expand(dirtyFirst, dirtyLast - dirtyFirst + 1, _latest.bytes + 3*dirtyFirst);
+  widenRange(first, last, dirtyFirst, dirtyLast);
+}
+
+// while rendering the frame is kept for later. Anything else is shown now, and
+// what was prepared before it would undo it, so that goes (its changes with it)
+void RenderAhead::show(FrameSource &aFrame) {
+  if (_rendering) {
+    capture(aFrame, _capturedFirst, _capturedLast);
+    return;
+  }
+  while (_count > 0) {
+    PreparedFrame &waiting = _ring[_head];
+    widenRange(_unsentFirst, _unsentLast, waiting.changedFirst, waiting.changedLast);
+    _head = (_head + 1) % kRenderAheadFrames;
+    _count -= 1;
+    _framesDiscarded += 1;
+  }
+  capture(aFrame, _unsentFirst, _unsentLast);
+  unsigned long now = millis();
+  _latest.due = now;
+  send(_latest, now);
+  _renderedTo = now;                        // a new start is timed from now
+}
+
+/************************************************************************************
+ * run the animation a millisecond at a time from where it got to, each frame it
+ * shows going into the ring, until the ring is full or far enough ahead. Quiet
+ * milliseconds cost one Continue() that does nothing. If it has fallen behind the
+ * clock it carries on from now, like Continue() after a slow loop().
+ ************************************************************************************/
+void RenderAhead::render(Animation &anAnimation, unsigned long now) {
+  while ((_count < kRenderAheadFrames) && anAnimation.Active()) {
+    unsigned long when = _renderedTo + 1;
+    if (long(now - when) > 0) {
+      when = now;
+    }
+    if (long(when - now) > kRenderAheadMillis) {
+      return;
+    }
+    _rendering = true;
+    _renderTime = when;
+    anAnimation.Continue();
+    _rendering = false;
+    _renderedTo = when;
+    if (_capturedFirst > _capturedLast) {
+      continue;                             // nothing changed this millisecond
+    }
+    PreparedFrame &aFrame = _ring[(_head + _count) % kRenderAheadFrames];
+    aFrame.pixels = _latest.pixels;
+    aFrame.due = when;
+    aFrame.changedFirst = _capturedFirst;
+    aFrame.changedLast = _capturedLast;
+    memcpy(aFrame.bytes, _latest.bytes, 3*_latest.pixels);
+    _count += 1;
+    _capturedFirst = 1;
+    _capturedLast = 0;
+  }
+}
+
+// if more than one frame is due, the others are too late to be worth sending
+void RenderAhead::flush(unsigned long now) {
+  if ((_count == 0) || (long(now - _ring[_head].due) < 0)) {
+    return;
+  }
+  TRACE_BEGIN(trFlush, 0);
+  while ((_count > 1) && (long(now - _ring[(_head + 1) % kRenderAheadFrames].due) >= 0)) {
+    PreparedFrame &skipped = _ring[_head];
+    widenRange(_unsentFirst, _unsentLast, skipped.changedFirst, skipped.changedLast);
+    _head = (_head + 1) % kRenderAheadFrames;
+    _count -= 1;
+    _framesSkipped += 1;
+  }
+  PreparedFrame &aFrame = _ring[_head];
+  widenRange(_unsentFirst, _unsentLast, aFrame.changedFirst, aFrame.changedLast);
+  send(aFrame, now);
+  _head = (_head + 1) % kRenderAheadFrames;
+  _count -= 1;
+  TRACE_END(trFlush, 0, now - aFrame.due);  // ms late
+}
+
+// aFrame goes out with everything not yet sent
+void RenderAhead::send(PreparedFrame &aFrame, unsigned long now) {
+  aFrame.changedFirst = _unsentFirst;
+  aFrame.changedLast = _unsentLast;
+  _unsentFirst = 1;
+  _unsentLast = 0;
+  if (aFrame.changedFirst > aFrame.changedLast) {
+    return;
+  }
+  _output.show(aFrame);
+  _framesSent += 1;
+  unsigned long late = now - aFrame.due;
+  _lateness[(late < kLatenessBuckets) ? late : kLatenessBuckets-1] += 1;
+  if (late > _maxLateness) {
+    _maxLateness = late;
+  }
+}
+
+// ms late that percent of the frames sent were no later than
+int RenderAhead::latenessPercentile(int percent) {
+  unsigned long wanted = (_framesSent * percent + 99) / 100;
+  unsigned long seen = 0;
+  for (int i=0; i<kLatenessBuckets; i++) {
+    seen += _lateness[i];
+    if ((seen >= wanted) && (seen > 0)) {
+      return i;
+    }
+  }
+  return kLatenessBuckets-1;
+}
+
+void RenderAhead::printStats() {
+  Serial.print("RenderAhead frames: "); Serial.print(_framesSent);
+  Serial.print(" skipped: "); Serial.print(_framesSkipped);
+  Serial.print(" discarded: "); Serial.print(_framesDiscarded);
+  Serial.print(" ms late p50: "); Serial.print(latenessPercentile(50));
+  Serial.print(" p99: "); Serial.print(latenessPercentile(99));
+  Serial.print(" max: "); Serial.println(_maxLateness);
+}
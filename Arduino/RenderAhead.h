@@ -0,0 +1,122 @@
+/*!
+ * @file RenderAhead.h
+ *
+ * @mainpage Arduino library for frames prepared ahead of the time they're shown
+ *
+ * @section intro_sec Introduction
+ *
+ * Some animations (ColorWipe, Marquee, the swirls, FadeToColor; see
+ * Animation::Deterministic()) draw the same frames whenever they're
+ * asked, given only the time. RenderAhead runs such an animation up to
+ * kRenderAheadMillis ahead of the clock, in loop()'s spare time, and
+ * keeps the frames it draws (expanded, in strip order) in a ring of
+ * kRenderAheadFrames, each with the time it's due. flush() is then all
+ * that has to happen on time: it sends the newest frame that's due to
+ * the real output. A slow light level read or a burst of logging no
+ * longer delays drawing and expanding a frame, only (at worst) sending
+ * one that's ready.
+ *
+ * RenderAhead is itself a StripOutput, put between the frame and the
+ * real output. While it is running the animation, clock() is the time of
+ * the frame being prepared (the animations ask animationMillis(), which
+ * the sketch points here) and show() keeps the frame in the ring. Any
+ * other show() (an animation starting, a PIR indicator changing) goes
+ * straight out, and the frames prepared before it are thrown away; the
+ * animation itself is by then up to kRenderAheadMillis further on, so it
+ * jumps forward that much.
+ *
+ * The ring costs (kRenderAheadFrames+1)*3 bytes per LED. How late each
+ * frame was sent is kept as a histogram; printStats() gives p50 and p99.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * RenderAhead.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "AnimationGlobals.h"
+#include "Animation.h"
+#include "StripOutput.h"
+
+#ifndef RenderAhead_h
+#define RenderAhead_h
+
+#define kRenderAheadFrames 4                // frames prepared and waiting, at most
+#define kRenderAheadMillis 50               // how far ahead of the clock they may be
+#define kLatenessBuckets 16                 // 1 ms each; the last is that late or more
+
+/************************************************************************************
+ * a frame as expanded GRB bytes, in strip order, plus the LEDs that changed since
+ * the one before it
+ ************************************************************************************/
+class PreparedFrame : public FrameSource {
+  public:
+    bool dirtyRange(int &first, int &last);
+    void expand(int first, int count, uint8_t *grb);
+    int stripPixels();
+
+    uint8_t bytes[kNumberOfLEDs*3];
+    unsigned long due;                      // millis() it's to be shown at
+    int changedFirst;                       // LEDs changed,
+    int changedLast;                        // changedFirst > changedLast -> none
+    int pixels;                             // # of LEDs in bytes[]
+};
+
+/************************************************************************************
+ * frame.setOutput(&renderAhead) in place of the real output, then from loop():
+ * flush() as often as possible and render() whenever there's time
+ ************************************************************************************/
+class RenderAhead : public StripOutput {
+  public:
+    RenderAhead(StripOutput &output);
+    void begin();                           // begins the real output too
+    void show(FrameSource &aFrame);         // into the frame being prepared, or straight out
+    bool ready();
+    const char *name() { return "RenderAhead"; }
+
+    void render(Animation &anAnimation, unsigned long now);   // prepare frames until far enough ahead
+    void flush(unsigned long now);          // send the newest frame that's due
+    unsigned long clock();                  // millis(), or the time of the frame being prepared
+    bool idle();                            // no frames waiting to be sent?
+    void printStats();                      // frames sent, skipped & thrown away; how late
+
+  private:
+    StripOutput &_output;
+    PreparedFrame _ring[kRenderAheadFrames];
+    int _head;                              // oldest frame waiting
+    int _count;                             // # waiting
+    PreparedFrame _latest;                  // the frame as the last show() left it
+    int _unsentFirst;                       // LEDs changed in frames skipped or thrown away,
+    int _unsentLast;                        // to go out with the next one sent
+    bool _rendering;                        // running the animation ahead of the clock
+    unsigned long _renderTime;              // clock() while _rendering
+    unsigned long _renderedTo;              // frames are prepared up to this time
+    int _capturedFirst;                     // LEDs changed since the last frame in the ring
+    int _capturedLast;
+    unsigned long _framesSent;
+    unsigned long _framesSkipped;           // due at the same time as a later one
+    unsigned long _framesDiscarded;         // prepared, then overtaken by a show() that went straight out
+    unsigned long _lateness[kLatenessBuckets];
+    unsigned long _maxLateness;
+
+    void capture(FrameSource &aFrame, int &first, int &last);   // aFrame's changes -> _latest
+    void send(PreparedFrame &aFrame, unsigned long now);
+    int latenessPercentile(int percent);
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*!
+ * @file SettingsStore.cpp
+ *
+ * @mainpage Arduino library for keeping settings in flash across resets
+ *
+ * @section intro_sec Introduction
+ *
+ * Wear-levelled, CRC checked records in flash (or a file standing in for
+ * it when not on a SAMD board).
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * SettingsStore.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "SettingsStore.h"
+
+/************************************************************************************
+ * the flash: FlashStorage on SAMD boards, a file elsewhere
+ ************************************************************************************/
+#if defined(ARDUINO_ARCH_SAMD)
+#include <FlashStorage.h>
+
+// erase unit aligned space in program flash (what the library's Flash() macro does,
+// but keeping hold of the address); flash is memory mapped so reads are just copies
+__attribute__((__aligned__(kSettingsRowBytes)))
+static const uint8_t settingsRows[kSettingsRows*kSettingsRowBytes] = { };
+static FlashClass settingsFlash(settingsRows, sizeof(settingsRows));
+
+void SettingsStore::readSlot(int slot, Record &aRecord) {
+  memcpy(&aRecord, &settingsRows[slot*kSettingsRecordBytes], kSettingsRecordBytes);
+}
+
+void SettingsStore::writeSlot(int slot, const Record &aRecord) {
+  settingsFlash.write(&settingsRows[slot*kSettingsRecordBytes], &aRecord, kSettingsRecordBytes);
+}
+
+void SettingsStore::eraseRow(int row) {
+  settingsFlash.erase(&settingsRows[row*kSettingsRowBytes], kSettingsRowBytes);
+}
+#else
+#include <stdio.h>
+
+// the whole "flash", created erased if the file isn't there yet
+static FILE *openSettingsFile() {
+  FILE *file = fopen(kSettingsFile, "r+b");
+  if (file == NULL) {
+    file = fopen(kSettingsFile, "w+b");
+    if (file != NULL) {
+      uint8_t erased[kSettingsRowBytes];
+      memset(erased, 0xFF, sizeof(erased));
+      for (int row=0; row<kSettingsRows; row++) {
+        fwrite(erased, 1, sizeof(erased), file);
+      }
+    }
+  }
+  return file;
+}
+
+void SettingsStore::readSlot(int slot, Record &aRecord) {
+  memset(&aRecord, 0xFF, sizeof(aRecord));
+  FILE *file = openSettingsFile();
+  if (file == NULL) {
+    return;
+  }
+  fseek(file, long(slot)*kSettingsRecordBytes, SEEK_SET);
+  if (fread(&aRecord, 1, sizeof(aRecord), file) != sizeof(aRecord)) {
+    memset(&aRecord, 0xFF, sizeof(aRecord));
+  }
+  fclose(file);
+}
+
+// like flash, writing can only turn 1s into 0s
+void SettingsStore::writeSlot(int slot, const Record &aRecord) {
+  Record current;
+  readSlot(slot, current);
+  uint8_t *bytes = (uint8_t *)&current;
+  const uint8_t *newBytes = (const uint8_t *)&aRecord;
+  for (int i=0; i<kSettingsRecordBytes; i++) {
+    bytes[i] &= newBytes[i];
+  }
+  FILE *file = openSettingsFile();
+  if (file == NULL) {
+    return;
+  }
+  fseek(file, long(slot)*kSettingsRecordBytes, SEEK_SET);
+  fwrite(&current, 1, sizeof(current), file);
+  fclose(file);
+}
+
+void SettingsStore::eraseRow(int row) {
+  FILE *file = openSettingsFile();
+  if (file == NULL) {
+    return;
+  }
+  uint8_t erased[kSettingsRowBytes];
+  memset(erased, 0xFF, sizeof(erased));
+  fseek(file, long(row)*kSettingsRowBytes, SEEK_SET);
+  fwrite(erased, 1, sizeof(erased), file);
+  fclose(file);
+}
+#endif
+
+/************************************************************************************
+ * records
+ ************************************************************************************/
+SettingsStore::SettingsStore() {
+  _newest = -1;
+  _sequence = 0;
+  _writes = 0;
+}
+
+// CRC-16/CCITT (poly 0x1021, initial 0xFFFF); only run at start up and on save
+uint16_t SettingsStore::crc16(const uint8_t *bytes, int count) {
+  uint16_t crc = 0xFFFF;
+  for (int i=0; i<count; i++) {
+    crc ^= uint16_t(bytes[i]) << 8;
+    for (int bit=0; bit<8; bit++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool SettingsStore::validRecord(int slot, Record &aRecord) {
+  readSlot(slot, aRecord);
+  return (aRecord.magic == kSettingsMagic) && (aRecord.size <= kSettingsPayload) &&
+         (aRecord.crc == crc16((const uint8_t *)&aRecord, offsetof(Record, crc)));
+}
+
+bool SettingsStore::blankSlot(int slot) {
+  Record aRecord;
+  readSlot(slot, aRecord);
+  const uint8_t *bytes = (const uint8_t *)&aRecord;
+  for (int i=0; i<kSettingsRecordBytes; i++) {
+    if (bytes[i] != 0xFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SettingsStore::begin() {
+  _newest = -1;
+  _sequence = 0;
+  _writes = 0;
+  Record aRecord;
+  for (int slot=0; slot<kSettingsSlots; slot++) {
+    if (validRecord(slot, aRecord) && ((_newest < 0) || (aRecord.sequence > _sequence))) {
+      _newest = slot;
+      _sequence = aRecord.sequence;
+    }
+  }
+}
+
+bool SettingsStore::load(void *settings, int size) {
+  Record aRecord;
+  if ((_newest < 0) || !validRecord(_newest, aRecord) || (aRecord.size != size)) {
+    return false;                         // nothing saved, or saved by a different version
+  }
+  memcpy(settings, aRecord.payload, size);
+  return true;
+}
+
+/************************************************************************************
+ * save(): the next slot after the newest record. Moving into a new row erases it
+ * (it holds the oldest records); a slot that isn't blank (a write cut short) sends
+ * us on to the next row.
+ ************************************************************************************/
+bool SettingsStore::save(const void *settings, int size) {
+  if ((size <= 0) || (size > kSettingsPayload)) {
+    return false;
+  }
+  Record aRecord;
+  if ((_newest >= 0) && validRecord(_newest, aRecord) && (aRecord.size == size) &&
+      (memcmp(aRecord.payload, settings, size) == 0)) {
+    return true;                          // nothing new to save
+  }
+  int slot = (_newest + 1) % kSettingsSlots;
+  if (!blankSlot(slot) && ((slot % kSettingsSlotsPerRow) != 0)) {
+    slot = ((slot / kSettingsSlotsPerRow + 1) * kSettingsSlotsPerRow) % kSettingsSlots;
+  }
+  if ((slot % kSettingsSlotsPerRow) == 0) {
+    eraseRow(slot / kSettingsSlotsPerRow);
+  }
+  memset(&aRecord, 0, sizeof(aRecord));
+  aRecord.magic = kSettingsMagic;
+  aRecord.size = size;
+  aRecord.sequence = _sequence + 1;
+  memcpy(aRecord.payload, settings, size);
+  aRecord.crc = crc16((const uint8_t *)&aRecord, offsetof(Record, crc));
+  writeSlot(slot, aRecord);
+  _writes += 1;
+  Record check;
+  if (!validRecord(slot, check) || (check.sequence != aRecord.sequence)) {
+    return false;
+  }
+  _newest = slot;
+  _sequence = aRecord.sequence;
+  return true;
+}
+
+unsigned long SettingsStore::writes() {
+  return _writes;
+}
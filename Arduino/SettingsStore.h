@@ -0,0 +1,111 @@
+/*!
+ * @file SettingsStore.h
+ *
+ * @mainpage Arduino library for keeping settings in flash across resets
+ *
+ * @section intro_sec Introduction
+ *
+ * Saves a small block of settings (up to kSettingsPayload bytes) as a
+ * 32 byte record in a few rows of flash set aside for it. Each save()
+ * writes a new record after the last one rather than rewriting the same
+ * place, and a row is only erased when the records wrap round to it, so
+ * the flash wears evenly. Every record carries a sequence number and a
+ * CRC; load() returns the newest record whose CRC is good, so a save cut
+ * short by a reset just leaves the previous one in charge.
+ *
+ * save() does nothing if the settings are the same as the last ones
+ * saved; it's up to the caller to save only on meaningful change.
+ *
+ * On SAMD boards the flash is reserved in program memory with the
+ * FlashStorage library (uploading a new sketch erases it). Elsewhere the
+ * flash is a file, kSettingsFile, which behaves like flash: erased bytes
+ * are 0xFF and writing can only clear bits.
+ *
+ * A "row" here is the flash's erase unit, and the space is aligned to it
+ * so erasing one never touches program code: 256 bytes on the SAMD21,
+ * an 8 KB block on the SAMD51 (so two of them, 16 KB, rather than four).
+ *
+ * @section dependencies Dependencies
+ *
+ * On SAMD boards this file depends on the FlashStorage library.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * SettingsStore.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef SettingsStore_h
+#define SettingsStore_h
+
+#if defined(__SAMD51__)
+#define kSettingsRowBytes 8192                      // SAMD51 erase unit (a block of 16 pages)
+#define kSettingsRows 2                             // blocks set aside for records
+#else
+#define kSettingsRowBytes 256                       // SAMD21 erase unit (a row of 4 pages)
+#define kSettingsRows 4                             // rows set aside for records
+#endif
+#define kSettingsRecordBytes 32
+#define kSettingsPayload 22                         // room for settings in a record
+#define kSettingsSlots (kSettingsRows*kSettingsRowBytes/kSettingsRecordBytes)
+#define kSettingsSlotsPerRow (kSettingsRowBytes/kSettingsRecordBytes)
+#define kSettingsMagic 0x5354                       // "ST"
+
+#ifndef kSettingsFile
+#define kSettingsFile "stairway-settings.bin"       // host only: the "flash"
+#endif
+
+/************************************************************************************
+ * begin() once; then load() what was saved (false -> nothing valid yet) and save()
+ * when the settings change
+ ************************************************************************************/
+class SettingsStore {
+  public:
+    SettingsStore();
+    void begin();                             // find the newest record
+    bool load(void *settings, int size);      // copy the newest settings into settings
+    bool save(const void *settings, int size);  // false -> too big, or the write failed
+    unsigned long writes();                   // records written since begin()
+
+  private:
+    struct Record {
+      uint16_t magic;
+      uint8_t size;                           // bytes of payload in use
+      uint8_t unused;
+      uint32_t sequence;                      // the newest record has the highest
+      uint8_t payload[kSettingsPayload];
+      uint16_t crc;                           // CRC-16/CCITT of everything before it
+    };
+    static_assert(sizeof(Record) == kSettingsRecordBytes, "a record must fill its slot exactly");
+
+    int _newest;                              // slot of the newest good record, -1 -> none
+    uint32_t _sequence;                       // its sequence number
+    unsigned long _writes;
+
+    bool validRecord(int slot, Record &aRecord);
+    bool blankSlot(int slot);
+    static uint16_t crc16(const uint8_t *bytes, int count);
+
+    // the flash itself
+    void readSlot(int slot, Record &aRecord);
+    void writeSlot(int slot, const Record &aRecord);
+    void eraseRow(int row);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*!
+ * @file StairGeometry.cpp
+ *
+ * @mainpage Arduino library for where the steps are along the strip
+ *
+ * @section intro_sec Introduction
+ *
+ * The step table and the walking time estimate. See StairGeometry.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairGeometry.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "StairGeometry.h"
+
+StairGeometry::StairGeometry() {
+  _stepCount = 0;
+  _strides = 0;
+  _traverse = kDefaultTraverse;
+  _timed = false;
+}
+
+// spread the LEDs as evenly as they go; the odd ones over go to the lower steps
+void StairGeometry::begin(int firstLED, int lastLED) {
+  int leds = lastLED - firstLED + 1;
+  int count = constrain(kStairSteps, 1, min(leds, kMaxStairSteps));
+  int led = firstLED;
+  for (int n=0; n<count; n++) {
+    int width = leds / count + ((n < leds % count) ? 1 : 0);
+    _steps[n].firstLED = led;
+    _steps[n].lastLED = led + width - 1;
+    _steps[n].strides = 1;
+    led += width;
+  }
+  _stepCount = count;
+  _strides = count;
+}
+
+bool StairGeometry::setSteps(const StairStep *steps, int count) {
+  if ((count < 1) || (count > kMaxStairSteps)) {
+    return false;
+  }
+  _strides = 0;
+  for (int n=0; n<count; n++) {
+    _steps[n] = steps[n];
+    _steps[n].strides = max(steps[n].strides, uint8_t(1));
+    _strides += _steps[n].strides;
+  }
+  _stepCount = count;
+  return true;
+}
+
+int StairGeometry::steps() {
+  return _stepCount;
+}
+
+const StairStep &StairGeometry::step(int n) {
+  return _steps[n];
+}
+
+int StairGeometry::stepOf(int led) {
+  for (int n=0; n<_stepCount; n++) {
+    if ((led >= _steps[n].firstLED) && (led <= _steps[n].lastLED)) {
+      return n;
+    }
+  }
+  return -1;
+}
+
+// steps are in order, so those inside the LEDs are consecutive
+int StairGeometry::stepsWithin(int firstLED, int lastLED, int &firstStep) {
+  int count = 0;
+  firstStep = 0;
+  for (int n=0; n<_stepCount; n++) {
+    if ((_steps[n].firstLED >= firstLED) && (_steps[n].lastLED <= lastLED)) {
+      if (count == 0) {
+        firstStep = n;
+      }
+      count += 1;
+    }
+  }
+  return count;
+}
+
+int StairGeometry::strides(int firstLED, int lastLED) {
+  int firstStep;
+  int count = stepsWithin(firstLED, lastLED, firstStep);
+  int total = 0;
+  for (int n=firstStep; n<firstStep+count; n++) {
+    total += _steps[n].strides;
+  }
+  return total;
+}
+
+/************************************************************************************
+ * a walk over part of the stairs is scaled up to all of them. The first timing
+ * replaces the default; after that a quicker walk counts for half, a slower one for
+ * an eighth, so the estimate follows the quicker walkers
+ ************************************************************************************/
+void StairGeometry::walked(uint32_t ms, int strides) {
+  if ((strides > 0) && (strides < _strides)) {
+    ms = uint32_t(uint64_t(ms) * _strides / strides);
+  }
+  if ((ms < kQuickestTraverse) || (ms > kSlowestTraverse)) {
+    return;                                 // not one person end to end
+  }
+  if (!_timed) {
+    _traverse = ms;
+    _timed = true;
+  } else if (ms < _traverse) {
+    _traverse -= (_traverse - ms) / 2;
+  } else {
+    _traverse += (ms - _traverse) / 8;
+  }
+}
+
+uint32_t StairGeometry::traverseTime() {
+  return _traverse;
+}
+
+uint32_t StairGeometry::strideTime() {
+  return _traverse / max(_strides, 1);
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file StairGeometry.h
+ *
+ * @mainpage Arduino library for where the steps are along the strip
+ *
+ * @section intro_sec Introduction
+ *
+ * The animations see the strip as a line of LEDs from the bottom of the
+ * stairs to the top. StairGeometry says which of those LEDs light which
+ * step (or landing), bottom step first, and how long a walker takes to
+ * get across each: a step is one stride, a landing as many strides as it
+ * takes to cross. By default the LEDs are divided evenly between
+ * kStairSteps steps; setSteps() takes a table for stairs that aren't so
+ * regular.
+ *
+ * It also keeps an estimate of how long people take to walk the stairs,
+ * from the time between their PIRs (see walked(); with PIRs on the
+ * landings, that's a flight at a time), so animations can
+ * light the steps just ahead of a walker instead of the whole flight at a
+ * fixed speed. The estimate leans towards the quicker walkers, since
+ * lights behind someone are wasted but lights behind time leave them in
+ * the dark.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairGeometry.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef StairGeometry_h
+#define StairGeometry_h
+
+#ifndef kStairSteps
+#define kStairSteps 14                    // steps when the LEDs are divided evenly
+#endif
+#define kMaxStairSteps 32                 // steps & landings setSteps() can hold
+#define kDefaultTraverse 5000             // ms to walk the stairs until someone has been timed
+#define kQuickestTraverse 1500            // ms; timings outside these are ignored
+#define kSlowestTraverse 20000
+
+struct StairStep {
+  int16_t firstLED;                       // bottom-most LED of the step
+  int16_t lastLED;
+  uint8_t strides;                        // walking time, in steps; more for a landing
+};
+
+/************************************************************************************
+ * begin() once the frame's size is known; steps are numbered from the bottom
+ ************************************************************************************/
+class StairGeometry {
+  public:
+    StairGeometry();
+    void begin(int firstLED, int lastLED);  // kStairSteps even steps over first..last
+    bool setSteps(const StairStep *steps, int count);   // false if count > kMaxStairSteps
+    int steps();
+    const StairStep &step(int n);
+    int stepOf(int led);                    // -1 if between steps
+    int stepsWithin(int firstLED, int lastLED, int &firstStep);   // whole steps in the LEDs
+    int strides(int firstLED, int lastLED); // walking time across them, in steps
+
+    void walked(uint32_t ms, int strides=0);    // someone took ms over strides (0 -> all the stairs)
+    uint32_t traverseTime();                // ms the next walker is expected to take
+    uint32_t strideTime();                  // ms for them to cross one step
+
+  private:
+    StairStep _steps[kMaxStairSteps];
+    int _stepCount;
+    int _strides;                           // summed over all the steps
+    uint32_t _traverse;                     // estimate, ms
+    bool _timed;                            // anyone walked() yet?
+};
+
+#endif
@@ -0,0 +1,287 @@
+/*!
+ * @file StairMachine.cpp
+ *
+ * @mainpage Arduino library for the stairway's state machine
+ *
+ * @section intro_sec Introduction
+ *
+ * The transition table and the event queue. See StairMachine.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairMachine.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "StairMachine.h"
+#include "TraceLog.h"
+
+static_assert((kStairQueueSize & (kStairQueueSize - 1)) == 0, "kStairQueueSize must be a power of 2");
+
+enum StairAction { noAction, arriveTop, arriveBottom, quietTop, quietBottom, expireWalkers, offIfClear };
+
+struct StairTransition {
+  uint8_t action;                         // StairAction
+  uint8_t next;                           // StairState if the action returns true,
+  uint8_t otherwise;                      // and if it returns false
+};
+
+/************************************************************************************
+ * the whole machine. Rows are states, columns are events:
+ *   topOn, topOff, bottomOn, bottomOff, timeout
+ * arrivals, quiet PIRs & expiries return true while someone is still on the stairs;
+ * offIfClear returns true once the lights have gone off
+ ************************************************************************************/
+static const StairTransition transitions[kStairStates][kStairEvents] = {
+  { // idleState: dark, nobody on the stairs
+    { arriveTop, occupiedState, emptyingState }, { noAction, idleState, idleState },
+    { arriveBottom, occupiedState, emptyingState }, { noAction, idleState, idleState },
+    { noAction, idleState, idleState } },
+  { // occupiedState: lit, someone on the stairs
+    { arriveTop, occupiedState, emptyingState }, { quietTop, occupiedState, emptyingState },
+    { arriveBottom, occupiedState, emptyingState }, { quietBottom, occupiedState, emptyingState },
+    { expireWalkers, occupiedState, emptyingState } },
+  { // emptyingState: lit, everyone gone, waiting for the PIRs to go quiet (then off, see dispatch())
+    { arriveTop, occupiedState, emptyingState }, { quietTop, occupiedState, emptyingState },
+    { arriveBottom, occupiedState, emptyingState }, { quietBottom, occupiedState, emptyingState },
+    { noAction, emptyingState, emptyingState } }
+};
+
+/************************************************************************************
+ * WalkerQueue: a ring of start times
+ ************************************************************************************/
+WalkerQueue::WalkerQueue() {
+  clear();
+}
+
+void WalkerQueue::clear() {
+  _first = 0;
+  _count = 0;
+}
+
+bool WalkerQueue::push(uint32_t since) {
+  if (_count >= kStairWalkers) {
+    return false;
+  }
+  _since[(_first + _count) % kStairWalkers] = since;
+  _count += 1;
+  return true;
+}
+
+void WalkerQueue::pop() {
+  if (_count > 0) {
+    _first = (_first + 1) % kStairWalkers;
+    _count -= 1;
+  }
+}
+
+bool WalkerQueue::empty() {
+  return _count == 0;
+}
+
+int WalkerQueue::count() {
+  return _count;
+}
+
+uint32_t WalkerQueue::oldest() {
+  return _since[_first];
+}
+
+/************************************************************************************
+ * StairMachine
+ ************************************************************************************/
+StairMachine::StairMachine(StairHandler &handler, uint32_t minTraverse, uint32_t maxTraverse,
+                           uint32_t pirHold)
+  : _handler(handler) {
+  _minTraverse = minTraverse;
+  _maxTraverse = maxTraverse;
+  _pirHold = pirHold;
+  _topSince = 0;
+  _bottomSince = 0;
+  _topLeft = false;
+  _bottomLeft = false;
+  _state = idleState;
+  _top = false;
+  _bottom = false;
+  _finishFromTop = false;
+  _flight = 0;
+  _head = 0;
+  _tail = 0;
+  _dropped = 0;
+}
+
+StairState StairMachine::state() {
+  return _state;
+}
+
+int StairMachine::occupancy() {
+  return _down.count() + _up.count();
+}
+
+void StairMachine::setFlight(int flight) {
+  _flight = flight;
+}
+
+bool StairMachine::idle() {
+  return (_state == idleState) && (_head == _tail);
+}
+
+unsigned long StairMachine::dropped() {
+  return _dropped;
+}
+
+bool StairMachine::post(StairEventType type, uint32_t now) {
+  uint8_t next = (_head + 1) & (kStairQueueSize - 1);
+  if (next == _tail) {
+    _dropped += 1;
+    return false;
+  }
+  _queue[_head].time = now;
+  _queue[_head].type = type;
+  _head = next;
+  return true;
+}
+
+// has the person who's been on the stairs longest run out of time?
+bool StairMachine::timeoutDue(uint32_t now, uint32_t &due) {
+  if (occupancy() == 0) {
+    return false;
+  }
+  uint32_t oldest;
+  if (_down.empty()) {
+    oldest = _up.oldest();
+  } else if (_up.empty()) {
+    oldest = _down.oldest();
+  } else {
+    oldest = (int32_t(_down.oldest() - _up.oldest()) < 0) ? _down.oldest() : _up.oldest();
+  }
+  due = oldest + _maxTraverse;
+  return (now - oldest) >= _maxTraverse;
+}
+
+// a due timeout is stamped with when it was due, so it goes ahead of anything
+// posted since
+void StairMachine::update(bool top, bool bottom, uint32_t now) {
+  uint32_t due;
+  if (timeoutDue(now, due)) {
+    post(timeoutEvent, due);
+  }
+  if (top != _top) {
+    post(top ? topOnEvent : topOffEvent, now);
+  }
+  if (bottom != _bottom) {
+    post(bottom ? bottomOnEvent : bottomOffEvent, now);
+  }
+  run();
+}
+
+void StairMachine::run() {
+  while (_tail != _head) {
+    StairEvent anEvent = _queue[_tail];
+    _tail = (_tail + 1) & (kStairQueueSize - 1);
+    dispatch(anEvent);
+  }
+}
+
+void StairMachine::dispatch(const StairEvent &anEvent) {
+  switch (anEvent.type) {                 // levels first, so guards see them
+    case topOnEvent: _top = true; _topSince = anEvent.time; break;
+    case topOffEvent: _top = false; break;
+    case bottomOnEvent: _bottom = true; _bottomSince = anEvent.time; break;
+    case bottomOffEvent: _bottom = false; break;
+  }
+  const StairTransition &aTransition = transitions[_state][anEvent.type];
+  bool result = perform(aTransition.action, anEvent);
+  StairState previous = _state;
+  _state = StairState(result ? aTransition.next : aTransition.otherwise);
+  if ((_state == emptyingState) && perform(offIfClear, anEvent)) {
+    _state = idleState;                   // emptied with the PIRs already quiet
+  }
+  if (_state != previous) {               // the event that ended a state goes with it
+    TRACE_END(TraceSpan(trIdleState + previous), _flight, anEvent.type);
+    TRACE_BEGIN(TraceSpan(trIdleState + _state), _flight);
+  }
+}
+
+bool StairMachine::perform(uint8_t action, const StairEvent &anEvent) {
+  switch (action) {
+    case arriveTop:
+    case arriveBottom:
+      return arrive(action == arriveTop, anEvent.time);
+    case quietTop:
+    case quietBottom:
+      return quiet(action == quietTop, anEvent.time);
+    case expireWalkers:
+      return expire(anEvent.time);
+    case offIfClear:
+      if (_top || _bottom) {
+        return false;
+      }
+      _handler.lightsOff(_finishFromTop, anEvent.time);
+      return true;
+  }
+  return true;                            // noAction
+}
+
+// someone at one end: the longest waiting of those coming from the other end, if
+// they've had time to get here, or someone new
+bool StairMachine::arrive(bool atTop, uint32_t now) {
+  WalkerQueue &coming = atTop ? _up : _down;
+  bool &left = atTop ? _topLeft : _bottomLeft;
+  left = !coming.empty() && ((now - coming.oldest()) >= _minTraverse);
+  if (left) {
+    uint32_t walked = now - coming.oldest();
+    coming.pop();
+    _finishFromTop = !atTop;              // the animation follows them out
+    _handler.occupancyChanged(walkerLeft, !atTop, occupancy(), walked, now);
+  } else {
+    if (_state == idleState) {
+      _handler.lightsOn(atTop, now);
+    }
+    (atTop ? _down : _up).push(now);
+    _handler.occupancyChanged(walkerEntered, atTop, occupancy(), 0, now);
+  }
+  return occupancy() > 0;
+}
+
+// a PIR gone quiet. If its going active was taken for someone leaving but it stayed
+// active for longer than they'd keep it, someone else set off from that end
+bool StairMachine::quiet(bool atTop, uint32_t now) {
+  bool &left = atTop ? _topLeft : _bottomLeft;
+  uint32_t since = atTop ? _topSince : _bottomSince;
+  if ((now - since) > _pirHold + kStairHoldSlack) {
+    (atTop ? _down : _up).push(since);
+    _handler.occupancyChanged(walkerEntered, atTop, occupancy(), 0, now);
+  }
+  left = false;
+  return occupancy() > 0;
+}
+
+// whoever has run out of time turned back (or wasn't seen leaving)
+bool StairMachine::expire(uint32_t now) {
+  for (int direction=0; direction<2; direction++) {
+    bool fromTop = (direction == 0);
+    WalkerQueue &walkers = fromTop ? _down : _up;
+    while (!walkers.empty() && ((now - walkers.oldest()) >= _maxTraverse)) {
+      walkers.pop();
+      _finishFromTop = !fromTop;          // the animation goes back the way it came
+      _handler.occupancyChanged(walkerLost, fromTop, occupancy(), 0, now);
+    }
+  }
+  return occupancy() > 0;
+}
@@ -0,0 +1,160 @@
+/*!
+ * @file StairMachine.h
+ *
+ * @mainpage Arduino library for the stairway's state machine
+ *
+ * @section intro_sec Introduction
+ *
+ * People walking the stairs trip the PIR at the end they start from,
+ * then the one at the other end. The machine counts them: a PIR going
+ * active is someone arriving at that end, either leaving (if someone
+ * set off from the other end at least minTraverse ago, the longest
+ * waiting first) or entering. Anyone not seen leaving within
+ * maxTraverse is assumed to have turned back and is dropped. The lights
+ * go on with the first person and off as soon as the count is back to
+ * zero and both PIRs are quiet, so there's no fixed on time.
+ *
+ * Two PIRs can't tell everything: people arriving at the same end while
+ * its PIR is still active (within its hold time) count as one, and
+ * someone arriving from the other end within maxTraverse can be taken
+ * for a person leaving. The second is put right when it matters most,
+ * someone setting off just as another leaves by the same end: one
+ * person keeps a PIR active for its hold time (pirHold), so a PIR
+ * whose activation was taken for someone leaving and lasts longer than
+ * that says someone else was there too, and when it goes quiet they're
+ * counted as having set off from that end when it went active. Without
+ * that, the lights could go off with them halfway up.
+ *
+ * update() turns PIR level changes and the oldest person's time running
+ * out into timestamped events on a small queue. Each event is looked up
+ * in a table by state and event (no searching) to find an action and
+ * the next state; an action can also report that the stairs have
+ * emptied, which picks the table's other next state.
+ *
+ * What the lights do is up to a StairHandler, so the machine can be run
+ * on its own on a host computer (host/StateCheck.cpp runs it through
+ * every ordering of a few PIR edges, and through overlapping walkers).
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairMachine.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef StairMachine_h
+#define StairMachine_h
+
+#define kStairQueueSize 8                 // events waiting, must be a power of 2
+#define kStairWalkers 8                   // people tracked per direction
+#define minimumTraverseTime 2             // the sketch's quickest trip (seconds) up or down the stairs
+#define maximumTraverseTime 15            // and slowest; anyone longer turned back
+#define PIRHoldMillis 2500                // ms a PIR stays active after motion (its time setting)
+#define kStairHoldSlack 20               // ms longer than that is someone else at that end too
+
+enum StairState { idleState, occupiedState, emptyingState, kStairStates };
+
+enum StairEventType { topOnEvent, topOffEvent, bottomOnEvent, bottomOffEvent, timeoutEvent,
+                      kStairEvents };
+
+enum OccupancyChange { walkerEntered, walkerLeft, walkerLost };
+
+struct StairEvent {
+  uint32_t time;                          // millis() when it happened
+  uint8_t type;                           // StairEventType
+};
+
+/************************************************************************************
+ * what the lights do; fromTop says which end the animation starts (or finishes)
+ * from. occupancyChanged() is for indicators & logging, count is after the change
+ * and walked is how long someone who left took (0 for the other changes)
+ ************************************************************************************/
+class StairHandler {
+  public:
+    virtual ~StairHandler() {}
+    virtual void lightsOn(bool fromTop, uint32_t now) = 0;      // first person on the stairs
+    virtual void lightsOff(bool fromTop, uint32_t now) = 0;     // last one gone
+    virtual void occupancyChanged(OccupancyChange change, bool fromTop, int count, uint32_t walked,
+                                  uint32_t now) {
+      (void)change; (void)fromTop; (void)count; (void)walked; (void)now;
+    }
+};
+
+// people who set off from one end, oldest first
+class WalkerQueue {
+  public:
+    WalkerQueue();
+    void clear();
+    bool push(uint32_t since);            // false if full (the person isn't counted)
+    void pop();
+    bool empty();
+    int count();
+    uint32_t oldest();                    // when the longest waiting one set off
+
+  private:
+    uint32_t _since[kStairWalkers];
+    uint8_t _first;
+    uint8_t _count;
+};
+
+/************************************************************************************
+ * update() every loop(); the rest for anyone who needs to know
+ ************************************************************************************/
+class StairMachine {
+  public:
+    StairMachine(StairHandler &handler, uint32_t minTraverse, uint32_t maxTraverse,
+                 uint32_t pirHold=PIRHoldMillis);   // ms
+    void update(bool top, bool bottom, uint32_t now);   // post what changed, then run the queue
+    bool post(StairEventType type, uint32_t now);       // false if the queue is full
+    void run();                           // dispatch everything queued
+    StairState state();
+    int occupancy();                      // people thought to be on the stairs
+    bool idle();                          // nothing lit, nothing pending
+    unsigned long dropped();              // events lost to a full queue
+    void setFlight(int flight);           // which one it is, for the trace
+
+  private:
+    StairHandler &_handler;
+    StairState _state;
+    bool _top;                            // PIR levels as last posted
+    bool _bottom;
+    WalkerQueue _down;                    // entered at the top
+    WalkerQueue _up;                      // entered at the bottom
+    bool _finishFromTop;                  // which way the lights go off
+    int _flight;
+    uint32_t _minTraverse;
+    uint32_t _maxTraverse;
+    uint32_t _pirHold;
+    uint32_t _topSince;                   // when each PIR last went active
+    uint32_t _bottomSince;
+    bool _topLeft;                        // and whether that was taken for someone leaving
+    bool _bottomLeft;
+    StairEvent _queue[kStairQueueSize];
+    uint8_t _head;                        // next to write
+    uint8_t _tail;                        // next to dispatch
+    unsigned long _dropped;
+
+    bool timeoutDue(uint32_t now, uint32_t &due);
+    bool perform(uint8_t action, const StairEvent &anEvent);
+    bool arrive(bool atTop, uint32_t now);
+    bool quiet(bool atTop, uint32_t now);
+    bool expire(uint32_t now);
+    void dispatch(const StairEvent &anEvent);
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*!
+ * @file StairZones.cpp
+ *
+ * @mainpage Arduino library for stairs with PIRs on the landings too
+ *
+ * @section intro_sec Introduction
+ *
+ * Reading the PIRs and feeding the flights. See StairZones.h.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairZones.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "StairZones.h"
+
+#define directionWindow 20000         // ms; motion at a neighbour within this says which way
+
+StairZones::StairZones(PIR * const *sensors, int count) {
+  _sensors = sensors;
+  _count = constrain(count, 2, kMaxPIRZones);
+  for (int f=0; f<kMaxFlights; f++) {
+    _flights[f] = NULL;
+  }
+  _levels = 0;
+  _settled = 0;
+  _position = -1;
+  _direction = 0;
+  _positionTime = 0;
+}
+
+void StairZones::setFlight(int flight, StairMachine &machine) {
+  if ((flight >= 0) && (flight < flights())) {
+    _flights[flight] = &machine;
+    machine.setFlight(flight);
+  }
+}
+
+int StairZones::zones() {
+  return _count;
+}
+
+int StairZones::flights() {
+  return _count - 1;
+}
+
+PIR &StairZones::sensor(int zone) {
+  return *_sensors[zone];
+}
+
+int StairZones::firstLED(int flight) {
+  return _sensors[flight]->indicator();
+}
+
+int StairZones::lastLED(int flight) {
+  return _sensors[flight+1]->indicator();
+}
+
+/************************************************************************************
+ * one read() per PIR, plus a raw one until it has settled. A zone coming on moves
+ * the position there; if that's next to the last position, recently, it also says
+ * which way people are going
+ ************************************************************************************/
+uint8_t StairZones::read(uint32_t now) {
+  uint8_t levels = 0;
+  for (int z=0; z<_count; z++) {
+    uint8_t bit = 1 << z;
+    bool level = _sensors[z]->read();
+    if (!(_settled & bit) && !(level || _sensors[z]->readRaw())) {
+      _settled |= bit;                      // believe it only once it has really been LOW
+    }
+    if (level && (_settled & bit)) {
+      levels |= bit;
+      if (!(_levels & bit)) {
+        if ((_position >= 0) && (abs(z - _position) == 1) && ((now - _positionTime) < directionWindow)) {
+          _direction = z - _position;
+        }
+        _position = z;
+        _positionTime = now;
+      }
+    }
+  }
+  _levels = levels;
+  return levels;
+}
+
+// flight f is between zone f (its bottom) and zone f+1 (its top)
+void StairZones::update(uint32_t now) {
+  for (int f=0; f<flights(); f++) {
+    if (_flights[f] != NULL) {
+      _flights[f]->update(active(f+1), active(f), now);
+    }
+  }
+}
+
+uint8_t StairZones::levels() {
+  return _levels;
+}
+
+bool StairZones::active(int zone) {
+  return (_levels & (1 << zone)) != 0;
+}
+
+bool StairZones::settled(int zone) {
+  return (_settled & (1 << zone)) != 0;
+}
+
+bool StairZones::allSettled() {
+  return _settled == uint8_t((1 << _count) - 1);
+}
+
+bool StairZones::idle() {
+  for (int f=0; f<flights(); f++) {
+    if ((_flights[f] != NULL) && !_flights[f]->idle()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int StairZones::position() {
+  return _position;
+}
+
+int StairZones::direction() {
+  return _direction;
+}
+
+// from an end there's only one flight to go onto; from a landing it's the one the
+// direction points at
+int StairZones::activeFlight() {
+  if (_position < 0) {
+    return -1;
+  }
+  if (_position == 0) {
+    return 0;
+  }
+  if (_position == _count - 1) {
+    return flights() - 1;
+  }
+  if (_direction == 0) {
+    return -1;
+  }
+  return (_direction > 0) ? _position : _position - 1;
+}
@@ -0,0 +1,96 @@
+/*!
+ * @file StairZones.h
+ *
+ * @mainpage Arduino library for stairs with PIRs on the landings too
+ *
+ * @section intro_sec Introduction
+ *
+ * The PIRs, in order from the bottom of the stairs to the top: one at
+ * each end and one on each landing between. Each pair of neighbouring
+ * PIRs bounds a flight of stairs, and a flight's LEDs are the ones
+ * between the two PIRs' indicator LEDs. With just the two end PIRs there
+ * is one flight, the whole strip.
+ *
+ * Every flight has its own StairMachine, which sees the PIR above it as
+ * its top and the one below as its bottom, so someone going up three
+ * flights is three walkers one after the other and only the flights
+ * they're on (or about to be on) are lit. update() reads each PIR once
+ * and hands the levels to the flights that share it.
+ *
+ * A PIR's output is HIGH for a while after power up, so until it has
+ * been seen LOW its HIGH isn't believed (settled()).
+ *
+ * The zone that saw motion last, and the way people are going (from one
+ * PIR's motion to its neighbour's), give the flight they're heading onto
+ * (activeFlight()). The sketch runs its animation there, moving it from
+ * flight to flight as people go up or down, and starts it from the end
+ * they came from; see position() and direction().
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StairZones.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "PIR.h"
+#include "StairMachine.h"
+
+#ifndef StairZones_h
+#define StairZones_h
+
+#define kMaxPIRZones 8                    // PIRs, ends & landings; bits in a zone mask
+#define kMaxFlights (kMaxPIRZones-1)
+
+/************************************************************************************
+ * PIRs bottom first; setFlight() for each flight (0 is the bottom one) before the
+ * first update()
+ ************************************************************************************/
+class StairZones {
+  public:
+    StairZones(PIR * const *sensors, int count);
+    void setFlight(int flight, StairMachine &machine);
+    int zones();
+    int flights();
+    PIR &sensor(int zone);
+    int firstLED(int flight);               // the flight's LEDs, its PIRs' indicators included
+    int lastLED(int flight);
+
+    uint8_t read(uint32_t now);             // read every PIR once; bit z set -> zone z active
+    void update(uint32_t now);              // levels from the last read() to the flights
+    uint8_t levels();                       // as last read, settled PIRs only
+    bool active(int zone);
+    bool settled(int zone);
+    bool allSettled();
+    bool idle();                            // every flight dark & nothing pending
+
+    int position();                         // zone that last saw motion; -1 none yet
+    int direction();                        // +1 going up, -1 down, 0 don't know
+    int activeFlight();                     // flight the last motion leads onto; -1 don't know
+
+  private:
+    PIR * const *_sensors;
+    int _count;
+    StairMachine *_flights[kMaxFlights];
+    uint8_t _levels;
+    uint8_t _settled;
+    int _position;
+    int _direction;
+    uint32_t _positionTime;                 // when _position saw motion
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*!
+ * @file StripOutput.cpp
+ *
+ * @mainpage Arduino library for the places a PaletteFrame can be shown
+ *
+ * @section intro_sec Introduction
+ *
+ * NeoPixel, DotStar and file outputs for PaletteFrame.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StripOutput.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include <Adafruit_DotStar.h>
+#include "StripOutput.h"
+#include "PaletteFrame.h"
+
+void swapGRBtoRGB(uint8_t *bytes, int count) {
+  for (int i=0; i<count; i++) {
+    uint8_t green = bytes[0];
+    bytes[0] = bytes[1];
+    bytes[1] = green;
+    bytes += 3;
+  }
+}
+
+/************************************************************************************
+ * NeoPixelOutput
+ ************************************************************************************/
+NeoPixelOutput::NeoPixelOutput(Adafruit_NeoPixel &strip) : _strip(strip) {
+}
+
+void NeoPixelOutput::begin() {
+  _strip.begin();
+}
+
+// the library's buffer still holds the last frame, so only what changed is expanded
+void NeoPixelOutput::show(FrameSource &aFrame) {
+  int first, last;
+  if (!aFrame.dirtyRange(first, last) || (first >= int(_strip.numPixels()))) {
+    return;                                 // the strip is already showing this frame
+  }
+  last = min(last, int(_strip.numPixels()) - 1);
+  aFrame.expand(first, last - first + 1, _strip.getPixels() + 3*first);
+  _strip.show();
+}
+
+bool NeoPixelOutput::ready() {
+  return _strip.canShow();
+}
+
+/************************************************************************************
+ * DotStarOutput
+ ************************************************************************************/
+DotStarOutput::DotStarOutput(Adafruit_DotStar &strip) : _strip(strip) {
+}
+
+void DotStarOutput::begin() {
+  _strip.begin();
+}
+
+void DotStarOutput::show(FrameSource &aFrame) {
+  uint8_t grb[kOutputChunk*3];
+  int dirtyFirst, dirtyLast;
+  if (!aFrame.dirtyRange(dirtyFirst, dirtyLast)) {
+    return;                                 // the strip is already showing this frame
+  }
+  int end = min(dirtyLast + 1, int(_strip.numPixels()));
+  for (int first=dirtyFirst; first<end; first+=kOutputChunk) {
+    int count = min(kOutputChunk, end-first);
+    aFrame.expand(first, count, grb);
+    for (int i=0; i<count; i++) {
+      _strip.setPixelColor(first+i, grb[i*3+1], grb[i*3], grb[i*3+2]);
+    }
+  }
+  _strip.show();
+}
+
+/************************************************************************************
+ * FileOutput
+ ************************************************************************************/
+FileOutput::FileOutput(Print &sink) : _sink(sink) {
+  _frames = 0;
+}
+
+void FileOutput::show(FrameSource &aFrame) {
+  uint8_t bytes[kOutputChunk*3];
+  int numPixels = aFrame.stripPixels();
+  for (int first=0; first<numPixels; first+=kOutputChunk) {
+    int count = min(kOutputChunk, numPixels-first);
+    aFrame.expand(first, count, bytes);
+    swapGRBtoRGB(bytes, count);
+    _sink.write(bytes, count*3);
+  }
+  _frames += 1;
+}
+
+unsigned long FileOutput::framesWritten() {
+  return _frames;
+}
@@ -0,0 +1,117 @@
+/*!
+ * @file StripOutput.h
+ *
+ * @mainpage Arduino library for the places a PaletteFrame can be shown
+ *
+ * @section intro_sec Introduction
+ *
+ * PaletteFrame::show() hands the frame to a StripOutput, which expands it
+ * (PaletteFrame::expand() gives GRB bytes, a few pixels at a time if it
+ * likes) and sends it wherever it goes. The animations don't know or care
+ * which output is in use, so the same code can drive the stairway's
+ * NeoPixels, a DotStar strip, a network controller or a file. What an
+ * output is handed is a FrameSource (see FrameSource.h): the PaletteFrame
+ * itself, or a frame RenderAhead prepared earlier.
+ *
+ * The outputs here are:
+ *  NeoPixelOutput  an Adafruit_NeoPixel strip (blocking, interrupts off)
+ *  DotStarOutput   an Adafruit_DotStar (APA102) strip over SPI
+ *  FileOutput      raw RGB frames, one after another, to any Print (an SD
+ *                  card File, Serial, or a file on a host computer)
+ * DMAOutput.h and NetworkOutput.h have the others.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StripOutput.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include <Adafruit_DotStar.h>
+#include "FrameSource.h"
+
+#ifndef StripOutput_h
+#define StripOutput_h
+
+#define kOutputChunk 16                     // pixels expanded at a time by outputs without a buffer
+
+/************************************************************************************
+ * base class for all outputs
+ ************************************************************************************/
+class StripOutput {
+  public:
+    virtual ~StripOutput() {}
+    virtual void begin() = 0;               // called once, before the first show()
+    virtual void show(FrameSource &aFrame) = 0;    // expand aFrame and send it
+    virtual bool ready() { return true; }   // could show() start right away?
+    virtual const char *name() = 0;         // for debugging output & benchmarks
+};
+
+/************************************************************************************
+ * frame expanded straight into the NeoPixel library's buffer; the library's own
+ * brightness is never set so the bytes aren't scaled a second time. Only the
+ * frame's dirty range is expanded, and an unchanged frame isn't sent at all
+ ************************************************************************************/
+class NeoPixelOutput : public StripOutput {
+  public:
+    NeoPixelOutput(Adafruit_NeoPixel &strip);
+    void begin();
+    void show(FrameSource &aFrame);
+    bool ready();
+    const char *name() { return "NeoPixel"; }
+
+  private:
+    Adafruit_NeoPixel &_strip;
+};
+
+/************************************************************************************
+ * DotStar strips keep their own byte order, so pixels are set one by one; like
+ * NeoPixelOutput only the dirty range is redone
+ ************************************************************************************/
+class DotStarOutput : public StripOutput {
+  public:
+    DotStarOutput(Adafruit_DotStar &strip);
+    void begin();
+    void show(FrameSource &aFrame);
+    const char *name() { return "DotStar"; }
+
+  private:
+    Adafruit_DotStar &_strip;
+};
+
+/************************************************************************************
+ * numPixels*3 bytes of R, G, B per frame, nothing else; e.g. for ffmpeg:
+ *   -f rawvideo -pixel_format rgb24 -video_size <numPixels>x1
+ ************************************************************************************/
+class FileOutput : public StripOutput {
+  public:
+    FileOutput(Print &sink);
+    void begin() {}
+    void show(FrameSource &aFrame);
+    const char *name() { return "File"; }
+    unsigned long framesWritten();
+
+  private:
+    Print &_sink;
+    unsigned long _frames;
+};
+
+// GRB (as expand() writes them) -> RGB, in place
+void swapGRBtoRGB(uint8_t *bytes, int count);
+
+#endif
@@ -0,0 +1,127 @@
+/*!
+ * @file TraceLog.cpp
+ *
+ * @mainpage Arduino library for capturing a timeline of what loop() did
+ *
+ * @section intro_sec Introduction
+ *
+ * The trace ring, its trigger and its drain. Nothing here is compiled
+ * unless kTracing is 1.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * TraceLog.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "TraceLog.h"
+
+#if kTracing
+
+static_assert((kTraceRecords & (kTraceRecords - 1)) == 0, "kTraceRecords must be a power of 2");
+
+TraceLog traceLog;
+
+TraceLog::TraceLog() {
+  _head = 0;
+  _count = 0;
+  _afterTrigger = -1;
+  _frozen = false;
+  _sent = -1;
+  _sink = NULL;
+}
+
+void TraceLog::setSink(Print *out) {
+  _sink = out;
+}
+
+// the oldest record is overwritten; nothing is recorded while a capture is frozen
+void TraceLog::add(TraceSpan span, uint8_t phase, int16_t track, int32_t arg) {
+  TraceRecord aRecord = { uint32_t(micros()), uint8_t(span), phase, track, arg };
+  if (_sink != NULL) {
+    writeFrame(*_sink, aRecord);
+    return;
+  }
+  if (_frozen) {
+    return;
+  }
+  _records[_head] = aRecord;
+  _head = (_head + 1) & (kTraceRecords - 1);
+  if (_count < kTraceRecords) {
+    _count += 1;
+  }
+  if ((_afterTrigger > 0) && (--_afterTrigger == 0)) {
+    _frozen = true;
+  }
+}
+
+// a second trigger before the first capture is out is only recorded
+void TraceLog::trigger(int32_t arg) {
+  add(trTrigger, tracePhaseInstant, 0, arg);
+  if ((_sink == NULL) && (_afterTrigger < 0)) {
+    _afterTrigger = kTracePostRecords;
+  }
+}
+
+bool TraceLog::frozen() {
+  return _frozen;
+}
+
+void TraceLog::writeFrame(Print &out, const TraceRecord &aRecord) {
+  uint8_t frame[kTraceFrameBytes];
+  uint32_t values[3] = { aRecord.time, uint32_t(aRecord.span) | (uint32_t(aRecord.phase) << 8) |
+                         (uint32_t(uint16_t(aRecord.track)) << 16), uint32_t(aRecord.arg) };
+  uint8_t check = 0;
+  frame[0] = kTraceFrameSync;
+  for (int i=0; i<kTraceRecordBytes; i++) {  // little endian whatever the processor
+    uint8_t aByte = values[i / 4] >> (8 * (i % 4));
+    frame[1 + i] = aByte;
+    check ^= aByte;
+  }
+  frame[kTraceFrameBytes - 1] = check;
+  out.write(frame, kTraceFrameBytes);
+}
+
+// oldest first, after a trCapture giving the count; then the ring starts again
+int TraceLog::drain(Print &out) {
+  if (!_frozen) {
+    return 0;
+  }
+  int sent = 0;
+  if ((_sent < 0) && (out.availableForWrite() >= kTraceFrameBytes)) {
+    TraceRecord capture = { uint32_t(micros()), trCapture, tracePhaseInstant, 0, _count };
+    writeFrame(out, capture);
+    _sent = 0;
+    sent += 1;
+  }
+  while ((_sent >= 0) && (_sent < _count) && (sent < kTraceDrainRecords) &&
+         (out.availableForWrite() >= kTraceFrameBytes)) {
+    writeFrame(out, _records[(_head - _count + _sent) & (kTraceRecords - 1)]);
+    _sent += 1;
+    sent += 1;
+  }
+  if (_sent == _count) {
+    _count = 0;
+    _sent = -1;
+    _afterTrigger = -1;
+    _frozen = false;
+  }
+  return sent;
+}
+
+#endif
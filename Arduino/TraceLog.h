@@ -0,0 +1,126 @@
+/*!
+ * @file TraceLog.h
+ *
+ * @mainpage Arduino library for capturing a timeline of what loop() did
+ *
+ * @section intro_sec Introduction
+ *
+ * The profile (Profiler.h) says how long things took on the whole; a
+ * trace says what happened around the one frame that was late. While
+ * tracing, frames, render-ahead flushes, light level reads, PIR edges
+ * and state changes are recorded as begin, end and instant records
+ * (12 bytes: time in micros, id, phase, track, argument) in a ring that
+ * keeps the latest kTraceRecords. trigger() marks the moment something
+ * went wrong; kTracePostRecords later recording stops, so the ring holds
+ * what led up to it and a little of what followed. drain() then sends
+ * the capture to Serial, at most kTraceDrainRecords records (56 bytes)
+ * per call as EventLog does, since availableForWrite() on the SAMD's USB
+ * Serial doesn't say how much would fit; recording starts again once
+ * it's all gone.
+ *
+ * On the wire each record is a frame like EventLog's: 0x5A, the 12
+ * record bytes (little endian) and an XOR check byte, and each capture
+ * starts with a trCapture record. host/traceToChrome.py turns a Serial
+ * capture into Chrome trace JSON (chrome://tracing, ui.perfetto.dev),
+ * using the names in TraceSpans.h; EventLog records in the same capture
+ * are shown too.
+ *
+ * On the host setSink() sends every record straight to a file instead,
+ * so a simulation's whole run is traced, not just a ring of it.
+ *
+ * Set kTracing to 1 to use it; at 0 the macros compile to nothing and
+ * there is no ring.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * TraceLog.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+
+#ifndef TraceLog_h
+#define TraceLog_h
+
+#ifndef kTracing
+#define kTracing 0                        // 1 -> TRACE_BEGIN() etc. record into the ring
+#endif
+#define kTraceRecords 128                 // ring size, must be a power of 2
+#define kTracePostRecords (kTraceRecords / 4)   // recorded after a trigger
+#define kTraceDrainRecords 4              // most records drain() sends per call
+#define kTraceFrameSync 0x5A
+#define kTraceRecordBytes 12
+#define kTraceFrameBytes (kTraceRecordBytes + 2)
+
+// record ids, in TraceSpans.h order
+#define TRACE_SPAN_ENTRY(name, text, track) name,
+enum TraceSpan {
+#include "TraceSpans.h"
+  trSpanCount
+};
+#undef TRACE_SPAN_ENTRY
+
+// the Chrome trace phases
+#define tracePhaseBegin 'B'
+#define tracePhaseEnd 'E'
+#define tracePhaseInstant 'i'
+
+struct TraceRecord {
+  uint32_t time;                          // micros()
+  uint8_t span;
+  uint8_t phase;
+  int16_t track;                          // PIR pin, flight...
+  int32_t arg;
+};
+
+/************************************************************************************
+ * one global instance, traceLog; use it through the macros
+ ************************************************************************************/
+class TraceLog {
+  public:
+    TraceLog();
+    void add(TraceSpan span, uint8_t phase, int16_t track, int32_t arg);
+    void trigger(int32_t arg);            // record a trTrigger, freeze kTracePostRecords later
+    bool frozen();                        // a capture is waiting to be drained
+    int drain(Print &out);                // send up to kTraceDrainRecords; returns # sent
+    void setSink(Print *out);             // every record straight to out (NULL: the ring)
+
+  private:
+    TraceRecord _records[kTraceRecords];
+    uint16_t _head;                       // next to write
+    uint16_t _count;                      // records in the ring
+    int16_t _afterTrigger;                // records still to keep, -1 if not triggered
+    bool _frozen;
+    int16_t _sent;                        // of the capture, -1 before its trCapture
+    Print *_sink;
+
+    void writeFrame(Print &out, const TraceRecord &aRecord);
+};
+
+#if kTracing
+extern TraceLog traceLog;
+
+#define TRACE_BEGIN(span, track) traceLog.add((span), tracePhaseBegin, (track), 0)
+#define TRACE_END(span, track, arg) traceLog.add((span), tracePhaseEnd, (track), (arg))
+#define TRACE_INSTANT(span, track, arg) traceLog.add((span), tracePhaseInstant, (track), (arg))
+#else
+#define TRACE_BEGIN(span, track) do { } while (0)
+#define TRACE_END(span, track, arg) do { } while (0)
+#define TRACE_INSTANT(span, track, arg) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/*!
+ * @file TraceSpans.h
+ *
+ * @mainpage The spans and instants TraceLog can record
+ *
+ * @section intro_sec Introduction
+ *
+ * One TRACE_SPAN_ENTRY(name, "text", "track") per kind of record. The
+ * position in the list is its id in the trace, so add new ones at the
+ * end. The texts are only used by the converter (host/traceToChrome.py
+ * reads this file), never on the board: "text" names the span in the
+ * trace viewer and "track" is the row it's drawn on, {track} in it being
+ * replaced by the record's track number (a PIR's pin, a flight).
+ *
+ * The three stair states are in StairState order; StairMachine traces
+ * trIdleState + its state.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * TraceSpans.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+// no include guard: included more than once with different TRACE_SPAN_ENTRY definitions
+
+TRACE_SPAN_ENTRY(trCapture, "capture", "trace")
+TRACE_SPAN_ENTRY(trTrigger, "slow loop()", "trace")
+TRACE_SPAN_ENTRY(trFrame, "frame", "output")
+TRACE_SPAN_ENTRY(trFlush, "render-ahead flush", "output")
+TRACE_SPAN_ENTRY(trLightLevel, "ADC read", "light level")
+TRACE_SPAN_ENTRY(trPIREdge, "edge", "PIR on pin {track}")
+TRACE_SPAN_ENTRY(trPIRSettled, "settled", "PIR on pin {track}")
+TRACE_SPAN_ENTRY(trIdleState, "idle", "flight {track}")
+TRACE_SPAN_ENTRY(trOccupiedState, "occupied", "flight {track}")
+TRACE_SPAN_ENTRY(trEmptyingState, "emptying", "flight {track}")
@@ -35,6 +35,7 @@
 #include "Arduino.h"
 #include <Adafruit_NeoPixel.h>
 #include "Twinkle.h"
+#include "PaletteFrame.h"
 
 #define twinkleTurningOn 0        // we're turning on LEDs
 #define twinkleTwinkling 1        // we're twinkling LEDs
@@ -59,21 +60,21 @@ void Twinkle::twinkleFinish(bool desiredState) {    // wrap things up (maybe)
   }
 // loop through pixels to see if any are not ON & pick a color and turn them on
   for (int i=_firstLED; i<=_lastLED; i++) {
-    if (_LEDArray[i] != desiredState) {
+    if (_state->lit[i] != desiredState) {
       uint32_t aColor = randomColor();
       if (!desiredState) {
         aColor = offColor;
       }
-      pixels.setPixelColor(i, aColor);
+      frame.setPixelColor(i, aColor);
     }
   }
-  pixels.show();                                  // finally, show the changes
+  frame.show();                                  // finally, show the changes
 }
 
 // setup to twinkle a few of the LEDs
 void Twinkle::twinkleSomeInit() {
   for (int i=0; i<_MAXTOTWINKLE; i++) {            // choose some LEDs to twinkle
-    _twinkleIndices[i] = random(_firstLED, _lastLED-1);
+    _state->twinkling[i] = random(_firstLED, _lastLED-1);
   }
   _twinkleState = twinkleTwinkling;               // set the mode
   _twinkleToOn = false;                           // start by turning LEDs off
@@ -82,7 +83,7 @@ void Twinkle::twinkleSomeInit() {
 
 bool Twinkle::indexInIndices(int newIdx) {        // check to see if an LED we're about to choose
   for (int i=0; i<_MAXTOTWINKLE; i++) {           // already exists in the twinkling set of LEDs
-    if (_twinkleIndices[i] == newIdx) {
+    if (_state->twinkling[i] == newIdx) {
       return true;                                // inform caller, which find a different LED to use
     }
   }
@@ -91,34 +92,34 @@ bool Twinkle::indexInIndices(int newIdx) {        // check to see if an LED we'r
 
 // twinkle (turn off then back on) a few LEDs ~10% of strip
 void Twinkle::twinkleSomeLEDs() {
-  if (int(millis()-_lastUpdateTime) < (_animationStepIncrement*2)) {  // is it time?
+  if (int(animationMillis()-_lastUpdateTime) < (_animationStepIncrement*2)) {  // is it time?
     return;                                       // no, nothing to do
   }
   uint32_t aColor = offColor;                     // assume turn off
   if (_twinkleToOn) {                             // but we're turning it back on
     aColor = randomColor();                       // get a new color
   }
-  pixels.setPixelColor(_twinkleIndices[_twinkleIdx], aColor);
-  pixels.show();                                 // force the change to show
+  frame.setPixelColor(_state->twinkling[_twinkleIdx], aColor);
+  frame.show();                                 // force the change to show
   if (_twinkleToOn) {                            // if back on, change the pixel we'll do next time
     int newIdx;
     do {
       newIdx = random(_firstLED, _lastLED+1);
     } while (indexInIndices(newIdx));
-    _twinkleIndices[_twinkleIdx] = newIdx;
+    _state->twinkling[_twinkleIdx] = newIdx;
   }
   _twinkleIdx += 1;                             // walk over our "buffer"
   if (_twinkleIdx >= _MAXTOTWINKLE) {
     _twinkleIdx = 0;       // wrap around
     _twinkleToOn = !_twinkleToOn;               // and change on/off modes
   }
-  _lastUpdateTime = millis();
+  _lastUpdateTime = animationMillis();
 }
 
 // helper function used by Start and Finish
 void Twinkle::commonTwinkleInitiate() {
-  pixels.setBrightness(255);
-  _twinkleLongestTimeToWait = int(round(_animationTime*1000))+millis(); // max time for pattern
+  frame.setBrightness(255);
+  _twinkleLongestTimeToWait = int(round(_animationTime*1000))+animationMillis(); // max time for pattern
   _twinkleIdx = 0;
   _twinkleChangedCount = 0;                       // none changed yet
 }
@@ -128,6 +129,7 @@ void Twinkle::commonTwinkleInitiate() {
  ************************************************************************************/
 // Initialize our instance, base class handles it
 Twinkle::Twinkle(const char * animationName, float animationTime, int firstOffset, int lastOffset):Animation(animationName, animationTime, firstOffset, lastOffset) {
+  _state = NULL;
 }
 
 /************************************************************************************
@@ -135,13 +137,11 @@ Twinkle::Twinkle(const char * animationName, float animationTime, int firstOffse
  ************************************************************************************/
 void Twinkle::Start(bool topToBottom, uint32_t colorToUse) {
   setAllPixelsTo(offColor);
-  pixels.show();
+  frame.show();
   _topToBottom = topToBottom;                     // not used by this class, keeps compiler from complaining
   _colorToUse = colorToUse;                       // not used by this class, keeps compiler from complaining
-  for (int i=0; i<pixels.numPixels(); i++) {
-    _LEDArray[i] = false;
-  }
-  _active = true;
+  _state = (TwinkleState *)claimState(sizeof(TwinkleState));   // all LEDs off
+  _active = _state != NULL;
   _twinkleState = twinkleTurningOn;              // this animation has internal states
   _lastUpdateTime = 0;
   commonTwinkleInitiate();
@@ -157,7 +157,11 @@ void Twinkle::Continue() {
   if (!_active) {                               // nothing to do here if we're not active
     return;
   }
-  unsigned long now = millis();                 // appropriate amount of time elapsed?
+  if (!holdsState()) {                          // another animation has the arena
+    _active = false;
+    return;
+  }
+  unsigned long now = animationMillis();        // appropriate amount of time elapsed?
   if (int(now - _lastUpdateTime) < _animationStepIncrement) {
     return;                                     // no
   }
@@ -177,6 +181,7 @@ void Twinkle::Continue() {
       twinkleSomeInit();
     } else {
       _active = false;
+      releaseState();
     }
     return;
   }
@@ -187,22 +192,22 @@ void Twinkle::Continue() {
   int tryIdx = random(_firstLED, _lastLED);
   bool desiredState = _twinkleState == twinkleTurningOn;
   uint32_t aColor = randomColor();
-  if (_LEDArray[tryIdx] == desiredState) {
+  if (_state->lit[tryIdx] == desiredState) {
     int origTryIdx = tryIdx;
     do {
       tryIdx += 1;
       if (tryIdx > _lastLED) {
         tryIdx = _firstLED;
       }
-    } while ((_LEDArray[tryIdx] == desiredState) && (tryIdx != origTryIdx));
+    } while ((_state->lit[tryIdx] == desiredState) && (tryIdx != origTryIdx));
   }
   if (_twinkleState == twinkleTurningOff) {
     aColor = offColor;
   }
-  _LEDArray[tryIdx] = desiredState;
+  _state->lit[tryIdx] = desiredState;
   _twinkleChangedCount += 1;
-  pixels.setPixelColor(tryIdx, aColor);
-  pixels.show();
+  frame.setPixelColor(tryIdx, aColor);
+  frame.show();
   _lastUpdateTime = now;
 }
 
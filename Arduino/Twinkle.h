@@ -47,6 +47,11 @@
  * Finish():    intiates randomly turning off random LEDs, Continue()
  *              keeps this process going until all LEDs are OFF
  ************************************************************************************/
+struct TwinkleState {                     // working state, in the animation arena while active
+  bool lit[kNumberOfLEDs];                // on/off state of each LED
+  int16_t twinkling[kNumberOfLEDs/10];    // LEDs being turned off and on
+};
+
 class Twinkle : public Animation {
   public:
     Twinkle(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
@@ -58,10 +63,9 @@ class Twinkle : public Animation {
 
   protected:
     int _MAXTOTWINKLE = kNumberOfLEDs/10;
-    int _twinkleIndices[kNumberOfLEDs/10];
 
   private:
-    bool _LEDArray[kNumberOfLEDs];       // array containing on/off state of each LED
+    TwinkleState *_state;
     unsigned long _twinkleLongestTimeToWait;
     int _twinkleChangedCount;
     int _twinkleIdx;
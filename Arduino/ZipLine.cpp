@@ -11,6 +11,9 @@
  * 
  * ZipLineInverse lights the strip with a specified color and then
  * moves a black LED back and forth across the strip.
+ *
+ * The moving, bouncing and drawing is all done by ParticleEngine; the
+ * classes here just set up the particles.
  * 
  * @section author Author
  * 
@@ -41,101 +44,27 @@
 /************************************************************************************
  * rapidly move a single pixel back and forth
  ************************************************************************************/
-ZipLine::ZipLine(const char * animationName, float animationTime, int firstOffset, int lastOffset):Animation(animationName, animationTime, firstOffset, lastOffset) {
+ZipLine::ZipLine(const char * animationName, float animationTime, int firstOffset, int lastOffset):ParticleEngine(animationName, animationTime, firstOffset, lastOffset) {
 }
 
-// start up the animation
-void ZipLine::Start(bool topToBottom, uint32_t colorToUse) {
-  _topToBottom = topToBottom;
-  _colorToUse = colorToUse;
-  _active = true;
-  _zipIdx = _firstLED;
-  _zipInc = 1;
-  if (_topToBottom) {                         // assume top to bottom to start
-    _zipIdx= _lastLED;                        // but caller wanted bottom to top
-    _zipInc = -1;
+// one particle, starting at the end the person came in from
+void ZipLine::addParticles() {
+  if (_topToBottom) {
+    addParticle(_lastLED, -1, _headColor);
+  } else {
+    addParticle(_firstLED, 1, _headColor);
   }
-  pixels.setBrightness(mappedBrightness());   // use a dim version of whatever color
-  setAllPixelsTo(offColor, false);
-  _lastUpdateTime = millis();
-  pixels.setPixelColor(_zipIdx, _colorToUse); // moving a single pixel back and forth
-  pixels.show();
-  _lastUpdateTime = millis();                 // we've done first step here
 }
 
-// keep the animation going until completed
-void ZipLine::Continue() {
-  if (!_active) {                             // nothing to do here if we're not active
-    return;
-  }
-  unsigned long now = millis();
-  int elapsed = (now - _lastUpdateTime);
-  if (elapsed < _animationStepIncrement) {    // appropriate time elapsed?
-    return;                     // not yet
-  }
-  pixels.setPixelColor(_zipIdx, offColor);    // turn off currently on LED
-  _zipIdx += _zipInc;                         // step to next
-  if (_zipIdx > _lastLED) {                   // off end?
-    _zipIdx = _lastLED-1;                     // reverse direction
-    _zipInc = -_zipInc;
-  } else if (_zipIdx < _firstLED) {           // off other end
-    _zipIdx = _firstLED+1;                    // yep
-    _zipInc = -_zipInc;
-  }
-  pixels.setPixelColor(_zipIdx, _colorToUse);  // light new pixel
-  pixels.show();
-  _lastUpdateTime = now;                       // "schedule" next update
+void ZipLine::printSelf() {
+  Serial.print("ZipLine "); Serial.println(_animationStepIncrement);
 }
 
-// start the shutdown of the animation; in this case it's just running it again but with color=black
-void ZipLine::Finish(bool topToBottom) {
-  _topToBottom = topToBottom;
-  _active = false;                             // simple, just set pixels black, restore brightness & stop
-  setAllPixelsTo(offColor);
-  pixels.setBrightness(255);
-  pixels.show();
-}
-
-
 /************************************************************************************
  * light all LEDs and the rapidly move a single dark pixel back and forth
  ************************************************************************************/
 ZipLineInverse::ZipLineInverse(const char * animationName, float animationTime, int firstOffset, int lastOffset):ZipLine(animationName, animationTime, firstOffset, lastOffset) {
-}
-
-// start up the animation; nearly identical to ZipLine
-void ZipLineInverse::Start(bool topToBottom, uint32_t colorToUse) {
-  ZipLine::Start(topToBottom, colorToUse);
-  setAllPixelsTo(colorToUse);                // but here we light the strip and move a dark pixel
-}
-
-// keep the animation going until completed
-void ZipLineInverse::Continue() {
-  if (!_active) {                            // nothing to do here if we're not active
-    return;
-  }
-  unsigned long now = millis();
-  int elapsed = (now - _lastUpdateTime);
-  if (elapsed < _animationStepIncrement) {   // appropriate time elapsed?
-    return;                                  // not yet
-  }
-  pixels.setPixelColor(_zipIdx, _colorToUse); // turn the pixel back on
-  _zipIdx += _zipInc;
-  if (_zipIdx > _lastLED) {                 // off end?
-    _zipIdx = _lastLED-1;                   // reverse direction
-    _zipInc = -_zipInc;
-  } else if (_zipIdx < _firstLED) {         // other end?
-    _zipIdx = _firstLED+1;                  // yes, reverse
-    _zipInc = -_zipInc;
-  }
-  pixels.setPixelColor(_zipIdx, offColor);  // turn off new pixel
-  pixels.show();
-  _lastUpdateTime = now;                    // "schedule" next update
-}
-
-// start the shutdown of the animation; in this case it's just running it again but with color=black
-void ZipLineInverse::Finish(bool topToBottom) {
-  ZipLine::Finish(topToBottom);                 // use ZipLine's finish
+  _inverse = true;                          // light the strip and move a dark pixel
 }
 
 /************************************************************************************
@@ -144,154 +73,38 @@ void ZipLineInverse::Finish(bool topToBottom) {
 Zip2::Zip2(const char * animationName, float animationTime, int firstOffset, int lastOffset):ZipLine(animationName, animationTime, firstOffset, lastOffset) {
 }
 
-// start up the animation
-void Zip2::Start(bool topToBottom, uint32_t colorToUse) {
-  ZipLine::Start(topToBottom, colorToUse);
-  _zip2Idx = _lastLED;
-   if (topToBottom) {
-    _zip2Idx = _firstLED;
-  }
-  pixels.setPixelColor(_zipIdx, _colorToUse); // moving a single pixel back and forth
-  pixels.setPixelColor(_zip2Idx, _colorToUse);
-  pixels.show();
-}
-
-// keep the animation going until completed
-void Zip2::Continue() {
-  if (!_active) {                             // nothing to do here if we're not active
-    return;
-  }
-  unsigned long now = millis();
-  int elapsed = (now - _lastUpdateTime);
-  if (elapsed < _animationStepIncrement) {    // appropriate time elapsed?
-    return;                     // not yet
-  }
-  pixels.setPixelColor(_zipIdx, offColor);    // turn off currently on LED
-  pixels.setPixelColor(_zip2Idx, offColor);
-  _zipIdx += _zipInc;                         // step to next
-  if (_zipIdx > _lastLED) {                   // off end?
-    _zipIdx = _lastLED-1;                     // reverse direction
-    _zipInc = -_zipInc;
-  } else if (_zipIdx < _firstLED) {           // off other end
-    _zipIdx = _firstLED+1;                    // yep
-    _zipInc = -_zipInc;
-  }
-  _zip2Idx -= _zipInc;
-  if (_zip2Idx > _lastLED) {                   // off end?
-    _zip2Idx = _lastLED-1;                     // reverse direction
-  } else if (_zip2Idx < _firstLED) {           // off other end
-    _zip2Idx = _firstLED+1;                    // yep
+// a particle at each end heading toward each other
+void Zip2::addParticles() {
+  ZipLine::addParticles();
+  if (_topToBottom) {
+    addParticle(_firstLED, 1, _headColor);
+  } else {
+    addParticle(_lastLED, -1, _headColor);
   }
-  pixels.setPixelColor(_zipIdx, _colorToUse);  // light new pixel
-  pixels.setPixelColor(_zip2Idx, _colorToUse);  // light new pixel
-  pixels.show();
-  _lastUpdateTime = now;                       // "schedule" next update
 }
 
-// start the shutdown of the animation; in this case it's just running it again but with color=black
-void Zip2::Finish(bool topToBottom) {
-  ZipLine::Finish(topToBottom);
-}
-
-
 /************************************************************************************
  * Like ZipInverse, but starts a dark pixel and each end of the neopixel strip
  ************************************************************************************/
 Zip2Inverse::Zip2Inverse(const char * animationName, float animationTime, int firstOffset, int lastOffset):Zip2(animationName, animationTime, firstOffset, lastOffset) {
+  _inverse = true;
 }
 
-// start up the animation; nearly identical to ZipLine
-void Zip2Inverse::Start(bool topToBottom, uint32_t colorToUse) {
-  ZipLine::Start(topToBottom, colorToUse);
-  _zip2Idx = _lastLED;
-  if (topToBottom) {
-    _zip2Idx = _firstLED;
-  }
-  setAllPixelsTo(_colorToUse, false);
-  pixels.setPixelColor(_zipIdx, offColor); // moving a single pixel back and forth
-  pixels.setPixelColor(_zip2Idx, offColor);
-  pixels.show();
-}
-
-// keep the animation going until completed
-void Zip2Inverse::Continue() {
-  if (!_active) {                            // nothing to do here if we're not active
-    return;
-  }
-  unsigned long now = millis();
-  int elapsed = (now - _lastUpdateTime);
-  if (elapsed < _animationStepIncrement) {   // appropriate time elapsed?
-    return;                                  // not yet
-  }
-  pixels.setPixelColor(_zipIdx, _colorToUse); // turn the pixel back on
-  pixels.setPixelColor(_zip2Idx, _colorToUse); // turn the pixel back on
-  _zipIdx += _zipInc;
-  if (_zipIdx > _lastLED) {                 // off end?
-    _zipIdx = _lastLED-1;                   // reverse direction
-    _zipInc = -_zipInc;
-  } else if (_zipIdx < _firstLED) {         // other end?
-    _zipIdx = _firstLED+1;                  // yes, reverse
-    _zipInc = -_zipInc;
-  }
-  _zip2Idx -= _zipInc;
-  if (_zip2Idx > _lastLED) {                // off end?
-    _zip2Idx = _lastLED-1;                  // reverse direction
-  } else if (_zip2Idx < _firstLED) {        // off other end
-    _zip2Idx = _firstLED+1;                 // yep
-  }
-  pixels.setPixelColor(_zipIdx, offColor);  // turn off new pixel
-  pixels.setPixelColor(_zip2Idx, offColor); // turn off new pixel
-  pixels.show();
-  _lastUpdateTime = now;                    // "schedule" next update
-}
-
-// start the shutdown of the animation; in this case it's just running it again but with color=black
-void Zip2Inverse::Finish(bool topToBottom) {
-  ZipLine::Finish(topToBottom);             // use ZipLine's finish
-}
-
-
 /************************************************************************************
  * Lke Zip, but chooses a random color every so many steps
  ************************************************************************************/
 ZipR::ZipR(const char * animationName, float animationTime, int firstOffset, int lastOffset):ZipLine(animationName, animationTime, firstOffset, lastOffset) {
 }
 
-// start up the animation
-void ZipR::Start(bool topToBottom, uint32_t colorToUse) {
-  ZipLine::Start(topToBottom, colorToUse);
+void ZipR::addParticles() {
+  ZipLine::addParticles();
   repeatCount = 0;
 }
 
-// keep the animation going until completed
-void ZipR::Continue() {
-  if (!_active) {                           // nothing to do here if we're not active
-    return;
-  }
-  unsigned long now = millis();
-  int elapsed = (now - _lastUpdateTime);
-  if (elapsed < _animationStepIncrement) { // appropriate time elapsed?
-    return;                     // not yet
-  }
-  pixels.setPixelColor(_zipIdx, offColor);    // turn off currently on LED
-  _zipIdx += _zipInc;                         // step to next
-  if (_zipIdx > _lastLED) {                   // off end?
-    _zipIdx = _lastLED-1;                     // reverse direction
-    _zipInc = -_zipInc;
-  } else if (_zipIdx < _firstLED) {           // off other end
-    _zipIdx = _firstLED+1;                    // yep
-    _zipInc = -_zipInc;
-  }
+// new color every 4th pixel
+void ZipR::particleStepped(int p) {
   repeatCount = (repeatCount + 1) % 4;
   if (repeatCount == 0) {
-    _colorToUse = randomColor();
+    _particles[p].color = randomColor();
   }
-  pixels.setPixelColor(_zipIdx, _colorToUse);  // light new pixel
-  pixels.show();
-  _lastUpdateTime = now;                       // "schedule" next update
-}
-
-// start the shutdown of the animation; in this case it's just running it again but with color=black
-void ZipR::Finish(bool topToBottom) {
-  ZipLine::Finish(topToBottom);
 }
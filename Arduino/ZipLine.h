@@ -11,6 +11,9 @@
  * 
  * ZipLineInverse lights the strip with a specified color and then
  * moves a black LED back and forth across the strip.
+ *
+ * All of the ZipLine family are presets of ParticleEngine (Particles.h),
+ * they only decide which particles to start with.
  * 
  * @section author Author
  * 
@@ -34,6 +37,7 @@
 #include "Arduino.h"
 #include <Adafruit_NeoPixel.h>
 #include "Animation.h"
+#include "Particles.h"
 
 #ifndef ZipLine_h
 #define ZipLine_h
@@ -41,32 +45,21 @@
 /************************************************************************************
  * rapidly move a single pixel back and forth
  ************************************************************************************/
-class ZipLine : public Animation {
+class ZipLine : public ParticleEngine {
   public:
     ZipLine(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
-    void Start(bool topToBottom, uint32_t colorToUse);
-    void Continue();
-    void Finish(bool topToBottom);
-    bool Active();
     void printSelf();
 
   protected:
-    int _zipIdx;
-    int _zipInc;
+    void addParticles();
 };
 
 /************************************************************************************
  * light all LEDs and the rapidly move a single dark pixel back and forth
  ************************************************************************************/
 class ZipLineInverse : public ZipLine {
-    public:
+  public:
     ZipLineInverse(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
-    void Start(bool topToBottom, uint32_t colorToUse);
-    void Continue();
-    void Finish(bool topToBottom);
-    bool Active();
-    void printSelf();
-
 };
 
 /************************************************************************************
@@ -75,14 +68,9 @@ class ZipLineInverse : public ZipLine {
 class Zip2 : public ZipLine {
   public:
     Zip2(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
-    void Start(bool topToBottom, uint32_t colorToUse);
-    void Continue();
-    void Finish(bool topToBottom);
-    bool Active();
-    void printSelf();
 
   protected:
-    int _zip2Idx;
+    void addParticles();
 };
 
 /************************************************************************************
@@ -91,11 +79,6 @@ class Zip2 : public ZipLine {
 class Zip2Inverse : public Zip2 {
   public:
     Zip2Inverse(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
-    void Start(bool topToBottom, uint32_t colorToUse);
-    void Continue();
-    void Finish(bool topToBottom);
-    bool Active();
-    void printSelf();
 };
 
 /************************************************************************************
@@ -104,14 +87,12 @@ class Zip2Inverse : public Zip2 {
 class ZipR : public ZipLine {
   public:
     ZipR(const char * animationName, float animationTime, int firstOffset=1, int lastOffset=-1);
-    void Start(bool topToBottom, uint32_t colorToUse);
-    void Continue();
-    void Finish(bool topToBottom);
-    bool Active();
-    void printSelf();
 
   protected:
     int repeatCount;
+
+    void addParticles();
+    void particleStepped(int p);
 };
 
 #endif
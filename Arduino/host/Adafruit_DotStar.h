@@ -0,0 +1,57 @@
+/*!
+ * @file Adafruit_DotStar.h
+ *
+ * @mainpage Host stand-in for the Adafruit_DotStar library
+ *
+ * @section intro_sec Introduction
+ *
+ * Keeps the colors it is given; show() takes as long on the virtual clock
+ * as sending them at 8MHz would.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Adafruit_DotStar.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef Host_Adafruit_DotStar_h
+#define Host_Adafruit_DotStar_h
+
+#include "Arduino.h"
+
+#define DOTSTAR_BGR (2 | (1 << 2) | (0 << 4))
+#define DOTSTAR_BRG (1 | (2 << 2) | (0 << 4))
+
+class Adafruit_DotStar {
+  public:
+    Adafruit_DotStar(uint16_t n, uint8_t dataPin, uint8_t clockPin, uint8_t order=DOTSTAR_BGR);
+    Adafruit_DotStar(uint16_t n, uint8_t order=DOTSTAR_BGR);
+    ~Adafruit_DotStar();
+    void begin() {}
+    void show();
+    void setPixelColor(uint16_t n, uint32_t c);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    uint32_t getPixelColor(uint16_t n) const;
+    void setBrightness(uint8_t b) { (void)b; }
+    uint16_t numPixels() const { return _numLEDs; }
+
+  private:
+    uint16_t _numLEDs;
+    uint32_t *_colors;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*!
+ * @file Adafruit_NeoPixel.h
+ *
+ * @mainpage Host stand-in for the Adafruit_NeoPixel library
+ *
+ * @section intro_sec Introduction
+ *
+ * Keeps the pixel buffer exactly as the library does (3 bytes per pixel
+ * in GRB order for NEO_GRB) so code that reads it sees the same thing.
+ * show() takes as long on the virtual clock as the real bit-banged
+ * transfer would: 30us per LED plus the latch.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Adafruit_NeoPixel.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef Host_Adafruit_NeoPixel_h
+#define Host_Adafruit_NeoPixel_h
+
+#include "Arduino.h"
+
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+  public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin, int type);
+    ~Adafruit_NeoPixel();
+    void begin();
+    void show();
+    void setPixelColor(uint16_t n, uint32_t c);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    uint32_t getPixelColor(uint16_t n) const;
+    void fill(uint32_t c=0, uint16_t first=0, uint16_t count=0);
+    void clear();
+    void setBrightness(uint8_t b);
+    uint8_t getBrightness() const;
+    uint16_t numPixels() const;
+    uint8_t *getPixels() const;
+    bool canShow();
+    unsigned long showCount() const;            // host only: # of show() calls
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+      return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+  private:
+    uint16_t _numLEDs;
+    uint8_t *_pixels;
+    uint8_t _brightness;
+    unsigned long _shows;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*!
+ * @file Arduino.h
+ *
+ * @mainpage Host (Linux/macOS) stand-in for the parts of the Arduino core we use
+ *
+ * @section intro_sec Introduction
+ *
+ * Lets the sketch's classes be compiled and run on a desktop computer
+ * for simulation and benchmarks. Time is a virtual clock: it only moves
+ * when delay()/delayMicroseconds() or hostAdvanceMicros() are called,
+ * when a strip is shown, and by 1us each time millis() or micros() is
+ * read (so busy-waits end), so runs are repeatable and as fast as the
+ * host allows. The clock and
+ * the simulated pins are per thread, so independent simulations can run
+ * side by side.
+ *
+ * Only what the sketch uses is provided. This directory is not compiled
+ * by the Arduino IDE.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Arduino.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef Host_Arduino_h
+#define Host_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+#define NOT_AN_INTERRUPT -1         // digitalPinToInterrupt() of a pin without one
+#define DEC 10
+#define HEX 16
+
+#define INTERNAL_DS_DATA 7          // Trinket M0 on-board DotStar pins
+#define INTERNAL_DS_CLK 8
+
+template <typename T> T constrain(T x, T low, T high) {
+  return (x < low) ? low : ((x > high) ? high : x);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+int analogRead(int pin);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int interrupt, void (*isr)(), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+/************************************************************************************
+ * Print/Serial: output goes to stdout (or nowhere, see hostSerialEnabled)
+ ************************************************************************************/
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int availableForWrite();
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(long n, int base=DEC);
+    size_t print(unsigned long n, int base=DEC);
+    size_t print(int n, int base=DEC) { return print(long(n), base); }
+    size_t print(unsigned int n, int base=DEC) { return print((unsigned long)n, base); }
+    size_t print(double n, int digits=2);
+    size_t println();
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HostSerial : public Print {
+  public:
+    void begin(unsigned long baud);
+    operator bool();                        // see hostSerialConnected()
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    int availableForWrite() { return 256; }
+};
+
+extern HostSerial Serial;
+
+#include "HostArduino.h"
+
+#endif
@@ -0,0 +1,320 @@
+/*!
+ * @file BatchRender.cpp
+ *
+ * @mainpage Host renderer of the animations to image files
+ *
+ * @section intro_sec Introduction
+ *
+ * Runs each animation in the table below on the virtual clock: Start(),
+ * Continue() every loopStep ms until it's done (or holdTime has gone),
+ * then Finish() and Continue() until it's done again. For each one it
+ * writes, into the output directory,
+ *  - <name>.rgb   every frame shown, as FileOutput sends it (R, G, B per
+ *                 LED); ffmpeg -f rawvideo -pixel_format rgb24
+ *                 -video_size <LEDs>x1 reads it
+ *  - <name>.ppm   a waterfall: one row per rowTime ms, the strip as it was
+ *                 then (LED 0 on the left), time going down the image
+ * and prints how long each phase took against the animation time it was
+ * given (marked (!) if more than 100 ms out), the number of frames and
+ * the longest gap between them. ColorWipe lights the stairs at walking
+ * pace (StairGeometry's default), not in its animation time.
+ *
+ * Built with -DkTracing=1 (and TraceLog.cpp) it also writes <name>.trace,
+ * every frame as a TraceLog span, for host/traceToChrome.py.
+ *
+ * The animations all draw into the one global frame, so each is rendered
+ * in a process of its own (fork()), as many at a time as there are
+ * cores. Nothing is shared; the results come back through a pipe.
+ *
+ * usage: batchRender [directory] [jobs]   (default . and one per core)
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * BatchRender.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "HostIO.h"
+#include "PaletteFrame.h"
+#include "StripOutput.h"
+#include "StairGeometry.h"
+#include "Animation.h"
+#include "ColorSwirl.h"
+#include "FadeAndWipe.h"
+#include "Twinkle.h"
+#include "ZipLine.h"
+#include "Particles.h"
+#include "TraceLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+#define loopStep 1                    // ms between Continue()s
+#define rowTime 10                    // ms of animation per waterfall row
+#define holdTime 10000                // ms before an animation that's still going is finished
+#define phaseLimit 20000              // ms an animation may take to finish
+#define reportBytes 256
+
+// what the animations expect the sketch to provide
+const uint32_t offColor = rgbColor(0, 0, 0);
+const uint32_t indicatorColor = rgbColor(10, 10, 10);
+const uint32_t renderColor = rgbColor(255, 160, 64);     // given to Start()
+PaletteFrame frame = PaletteFrame(kNumberOfLEDs);
+StairGeometry geometry;
+
+uint32_t randomColor() {
+  return renderColor;
+}
+
+int mappedBrightness() {
+  return 255;
+}
+
+unsigned long animationMillis() {
+  return millis();
+}
+
+// as stairway.ino has them
+ColorWipe colorWipe = ColorWipe("ColorWipe", 1.3);
+ZipLine zipLine = ZipLine("ZipLine", 2.0);
+ColorSwirl colorSwirl = ColorSwirl("Rainbow", -15);
+SingleSwirl singleSwirl = SingleSwirl("Fading colors", -15);
+Marquee marquee = Marquee("Marquee", -150);
+FadeToColor fadeToColor = FadeToColor("Fade to color", kFadeToColorTime);
+ZipLineInverse zipLineInverse = ZipLineInverse("ZipLine Inverse", 2.0);
+Twinkle twinkle = Twinkle("Twinkle", 1.75);
+Startup sup = Startup("Startup", 1.5);
+Zip2 zip2 = Zip2("Zip2", 2.0);
+Zip2Inverse zip2i = Zip2Inverse("Zip 2 inverse", 2.0);
+ZipR zipR = ZipR("Zip Random", 1.75);
+Walkers walkers = Walkers("Walkers", 6.0, 8);
+
+struct RenderJob {
+  const char *file;                   // <file>.rgb & <file>.ppm
+  Animation *animation;
+};
+
+static const RenderJob jobs[] = {
+  { "colorWipe", &colorWipe },
+  { "zipLine", &zipLine },
+  { "colorSwirl", &colorSwirl },
+  { "singleSwirl", &singleSwirl },
+  { "marquee", &marquee },
+  { "fadeToColor", &fadeToColor },
+  { "zipLineInverse", &zipLineInverse },
+  { "twinkle", &twinkle },
+  { "startup", &sup },
+  { "zip2", &zip2 },
+  { "zip2Inverse", &zip2i },
+  { "zipRandom", &zipR },
+  { "walkers", &walkers }
+};
+#define jobCount int(sizeof(jobs)/sizeof(jobs[0]))
+
+/************************************************************************************
+ * keeps the strip as last shown (for the waterfall) and passes every frame on to
+ * a FileOutput; notes when frames were shown
+ ************************************************************************************/
+class CaptureOutput : public StripOutput {
+  public:
+    CaptureOutput(StripOutput &raw) : _raw(raw) {
+      memset(strip, 0, sizeof(strip));
+      restart();
+    }
+    void begin() {
+      _raw.begin();
+    }
+    void show(FrameSource &aFrame) {
+      int first, last;
+      if (aFrame.dirtyRange(first, last) && (first < kNumberOfLEDs)) {
+        last = min(last, kNumberOfLEDs-1);
+        aFrame.expand(first, last - first + 1, strip + 3*first);
+      }
+      _raw.show(aFrame);
+      unsigned long now = millis();
+      if (frames > 0) {
+        longestGap = max(longestGap, now - lastShown);
+      }
+      lastShown = now;
+      frames += 1;
+    }
+    const char *name() { return "Capture"; }
+    void restart() {                  // counting frames for a new phase
+      frames = 0;
+      longestGap = 0;
+      lastShown = 0;
+    }
+
+    uint8_t strip[kNumberOfLEDs*3];   // GRB
+    unsigned long frames;
+    unsigned long longestGap;         // ms between frames
+    unsigned long lastShown;
+
+  private:
+    StripOutput &_raw;
+};
+
+// Continue() until the animation's done or limit ms have gone, adding waterfall rows;
+// returns the ms taken (limit if it never finished)
+static unsigned long runPhase(Animation *animation, unsigned long limit, CaptureOutput &capture,
+                              std::vector<uint8_t> &rows) {
+  unsigned long started = millis();
+  while (animation->Active() && (millis() - started < limit)) {
+    hostAdvanceMicros(loopStep * 1000);
+    animation->Continue();
+    if (millis() % rowTime == 0) {
+      for (int i=0; i<frame.stripPixels(); i++) {
+        rows.push_back(capture.strip[3*i+1]);   // GRB -> RGB
+        rows.push_back(capture.strip[3*i]);
+        rows.push_back(capture.strip[3*i+2]);
+      }
+    }
+  }
+  return millis() - started;
+}
+
+static void describePhase(char *text, size_t size, const char *phase, unsigned long took, bool done,
+                          CaptureOutput &capture) {
+  snprintf(text, size, " %s %.2f s%s, %lu frames, gap <= %lu ms;", phase, took / 1000.0,
+           done ? "" : " (still going)", capture.frames, capture.longestGap);
+}
+
+// in the child: render one job, write the report line to report
+static void renderJob(const RenderJob &job, const char *directory, int report) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s.rgb", directory, job.file);
+  HostFile rawFile;
+  if (!rawFile.open(path)) {
+    dprintf(report, "%-16s can't write %s\n", job.file, path);
+    return;
+  }
+  FileOutput raw = FileOutput(rawFile);
+#if kTracing
+  snprintf(path, sizeof(path), "%s/%s.trace", directory, job.file);
+  HostFile traceFile;
+  if (traceFile.open(path)) {
+    traceLog.setSink(&traceFile);
+  }
+#endif
+  CaptureOutput capture = CaptureOutput(raw);
+  hostSerialEnabled(false);
+  hostSetMicros(1000000);
+  randomSeed(1);
+  capture.begin();
+  frame.setOutput(&capture);
+  frame.begin();
+  frame.show();
+  geometry.begin(1, frame.numPixels()-2);
+  std::vector<uint8_t> rows;
+
+  capture.restart();
+  job.animation->Start(false, renderColor);
+  unsigned long onTime = runPhase(job.animation, holdTime, capture, rows);
+  bool onDone = !job.animation->Active();
+  char on[reportBytes];
+  describePhase(on, sizeof(on), "on", onTime, onDone, capture);
+  unsigned long onFrames = capture.frames;
+
+  capture.restart();
+  job.animation->Finish(false);
+  unsigned long offTime = runPhase(job.animation, phaseLimit, capture, rows);
+  char off[reportBytes];
+  describePhase(off, sizeof(off), "off", offTime, !job.animation->Active(), capture);
+  rawFile.close();
+#if kTracing
+  traceLog.setSink(NULL);
+  traceFile.close();
+#endif
+
+  snprintf(path, sizeof(path), "%s/%s.ppm", directory, job.file);
+  FILE *image = fopen(path, "wb");
+  int width = frame.stripPixels();
+  if (image != NULL) {
+    fprintf(image, "P6\n%d %d\n255\n", width, int(rows.size() / (3*width)));
+    fwrite(rows.data(), 1, rows.size(), image);
+    fclose(image);
+  }
+  char meant[64] = "";
+  float animationTime = job.animation->animationTime();
+  if (animationTime > 0) {
+    snprintf(meant, sizeof(meant), " meant %.2f s%s", animationTime,
+             (onDone && (onFrames > 0) && (labs(long(onTime) - long(animationTime*1000)) > 100)) ? " (!)" : "");
+  }
+  dprintf(report, "%-16s%s%s%s\n", job.file, on, off, meant);
+}
+
+int main(int argc, char **argv) {
+  const char *directory = (argc > 1) ? argv[1] : ".";
+  int parallel = (argc > 2) ? atoi(argv[2]) : int(sysconf(_SC_NPROCESSORS_ONLN));
+  parallel = max(parallel, 1);
+  int reports[jobCount];
+  pid_t children[jobCount];
+  int statuses[jobCount];
+  for (int j=0; j<jobCount; j++) {
+    if ((j >= parallel) && (children[j-parallel] > 0)) {   // the oldest finishes before another starts
+      waitpid(children[j-parallel], &statuses[j-parallel], 0);
+    }
+    int pipeEnds[2];
+    if (pipe(pipeEnds) != 0) {
+      perror("pipe");
+      return 1;
+    }
+    children[j] = fork();
+    if (children[j] < 0) {            // reported as failed below
+      perror("fork");
+      close(pipeEnds[0]);
+      close(pipeEnds[1]);
+      continue;
+    }
+    if (children[j] == 0) {
+      close(pipeEnds[0]);
+      renderJob(jobs[j], directory, pipeEnds[1]);
+      close(pipeEnds[1]);
+      _exit(0);
+    }
+    close(pipeEnds[1]);
+    reports[j] = pipeEnds[0];
+  }
+  int failed = 0;
+  for (int j=0; j<jobCount; j++) {
+    if (children[j] < 0) {
+      printf("%-16s didn't start\n", jobs[j].file);
+      failed += 1;
+      continue;
+    }
+    if (j >= jobCount-parallel) {
+      waitpid(children[j], &statuses[j], 0);
+    }
+    int status = statuses[j];
+    char text[4*reportBytes];
+    ssize_t length = read(reports[j], text, sizeof(text)-1);
+    close(reports[j]);
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0) || (length <= 0)) {
+      printf("%-16s failed\n", jobs[j].file);
+      failed += 1;
+      continue;
+    }
+    text[length] = '\0';
+    fputs(text, stdout);
+  }
+  printf("%d animations, %d LEDs, a row each %d ms, in %s\n", jobCount, frame.stripPixels(), rowTime, directory);
+  return (failed == 0) ? 0 : 1;
+}
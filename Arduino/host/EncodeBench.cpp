@@ -0,0 +1,112 @@
+/*!
+ * @file EncodeBench.cpp
+ *
+ * @mainpage Host benchmark for the WS2812 bitstream encoder
+ *
+ * @section intro_sec Introduction
+ *
+ * Measures encode throughput in LEDs per millisecond of real time for
+ * 1,000 and 10,000 LEDs:
+ *  bit by bit   the straightforward loop, one symbol per data bit
+ *  table        encodeWS2812(), two table lookups per byte
+ *  frame        PaletteFrame::expand() + encodeWS2812(), what DMAOutput
+ *               does for every frame
+ * and checks that the table gives the same bitstream as the loop, exiting
+ * non-zero if it doesn't. Build with -DkNumberOfLEDs=10000 so the frame
+ * can hold the larger strip (see README.md); a smaller build measures at
+ * most kNumberOfLEDs.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * EncodeBench.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+#include "DMAOutput.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#define benchRepeats 200
+
+const uint32_t indicatorColor = rgbColor(64, 0, 0);
+const uint32_t offColor = rgbColor(0, 0, 0);
+
+static void encodeBitByBit(const uint8_t *bytes, int count, uint8_t *bitstream) {
+  for (int i=0; i<count; i++) {
+    uint8_t aByte = bytes[i];
+    uint32_t symbols = 0;
+    for (int bit=0; bit<8; bit++) {
+      symbols = (symbols << 3) | ((aByte & 0x80) ? 0x6 : 0x4);
+      aByte <<= 1;
+    }
+    *bitstream++ = symbols >> 16;
+    *bitstream++ = symbols >> 8;
+    *bitstream++ = symbols;
+  }
+}
+
+template <typename F>
+static double ledsPerMillisecond(int numLEDs, F encodeOnce) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r=0; r<benchRepeats; r++) {
+    encodeOnce();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return double(numLEDs) * benchRepeats / elapsed.count();
+}
+
+// false if the encoders don't agree
+static bool bench(int numLEDs) {
+  std::vector<uint8_t> grb(numLEDs*3);
+  std::vector<uint8_t> slow(numLEDs*3*kWS2812BitsPerBit);
+  std::vector<uint8_t> fast(numLEDs*3*kWS2812BitsPerBit);
+  PaletteFrame *aFrame = new PaletteFrame(numLEDs);
+  aFrame->begin();
+  for (int i=0; i<numLEDs; i++) {
+    aFrame->setPixelColor(i, rgbColor(i*7, i*13, i*29));
+  }
+  aFrame->expand(0, numLEDs, grb.data());
+
+  double bitByBit = ledsPerMillisecond(numLEDs, [&]() { encodeBitByBit(grb.data(), numLEDs*3, slow.data()); });
+  double table = ledsPerMillisecond(numLEDs, [&]() { encodeWS2812(grb.data(), numLEDs*3, fast.data()); });
+  double frame = ledsPerMillisecond(numLEDs, [&]() {
+    uint8_t chunk[16*3];
+    uint8_t *out = fast.data();
+    for (int first=0; first<numLEDs; first+=16) {
+      int count = min(16, numLEDs-first);
+      aFrame->expand(first, count, chunk);
+      encodeWS2812(chunk, count*3, out);
+      out += count*3*kWS2812BitsPerBit;
+    }
+  });
+  bool same = (slow == fast);
+  printf("%6d LEDs: bit by bit %8.0f, table %8.0f, frame %8.0f LEDs/ms%s\n",
+         numLEDs, bitByBit, table, frame, same ? "" : "  ** bitstreams differ **");
+  delete aFrame;
+  return same;
+}
+
+int main() {
+  bool same = bench(min(1000, kNumberOfLEDs));
+  same = bench(min(10000, kNumberOfLEDs)) && same;
+  return same ? 0 : 1;
+}
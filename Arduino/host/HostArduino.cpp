@@ -0,0 +1,492 @@
+/*!
+ * @file HostArduino.cpp
+ *
+ * @mainpage Host (Linux/macOS) stand-in for the parts of the Arduino core we use
+ *
+ * @section intro_sec Introduction
+ *
+ * Implements the Arduino functions declared in host/Arduino.h and the
+ * NeoPixel/DotStar stand-ins. The virtual clock, pins, scheduled pin
+ * changes, interrupt handlers and random number state are thread_local.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * HostArduino.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "Adafruit_NeoPixel.h"
+#include "Adafruit_DotStar.h"
+#include <stdio.h>
+
+#define pollMicros 1                // each millis()/micros() call costs this much, so
+                                    // loops that just watch the clock still get somewhere
+#define ws2812MicrosPerLED 30       // 24 bits at 800kHz
+#define ws2812LatchMicros 300
+#define dotStarNanosPerLED 4000     // 32 bits at 8MHz
+
+static thread_local uint64_t virtualMicros = 0;
+static thread_local int pinValues[kHostPins];
+static thread_local int analogValues[kHostPins];
+static thread_local int pinsWritten[kHostPins];
+static thread_local uint32_t randomState = 1;
+static thread_local bool serialEnabled = true;
+static thread_local bool serialConnected = true;
+
+struct ScheduledPin {
+  uint64_t at;                      // virtual micros
+  int pin;
+  int value;
+};
+static thread_local ScheduledPin scheduled[kHostScheduledPins];
+static thread_local int scheduledCount = 0;
+static thread_local void (*pinISRs[kHostPins])();
+static thread_local int pinISRModes[kHostPins];
+static thread_local bool interruptless[kHostPins];
+
+static void applySchedule();
+
+HostSerial Serial;
+
+/************************************************************************************
+ * Time
+ ************************************************************************************/
+void hostSetMicros(uint64_t now) {
+  virtualMicros = now;
+  applySchedule();
+}
+
+void hostAdvanceMicros(uint64_t us) {
+  virtualMicros += us;
+  applySchedule();
+}
+
+uint64_t hostMicros() {
+  return virtualMicros;
+}
+
+unsigned long millis() {
+  virtualMicros += pollMicros;
+  applySchedule();
+  return (unsigned long)(virtualMicros / 1000);
+}
+
+unsigned long micros() {
+  virtualMicros += pollMicros;
+  applySchedule();
+  return (unsigned long)virtualMicros;
+}
+
+void delay(unsigned long ms) {
+  virtualMicros += uint64_t(ms) * 1000;
+  applySchedule();
+}
+
+void delayMicroseconds(unsigned int us) {
+  virtualMicros += us;
+  applySchedule();
+}
+
+/************************************************************************************
+ * Pins
+ ************************************************************************************/
+static bool validPin(int pin) {
+  return (pin >= 0) && (pin < kHostPins);
+}
+
+void hostSetPin(int pin, int value) {
+  if (validPin(pin)) {
+    pinValues[pin] = value;
+  }
+}
+
+void hostSetAnalog(int pin, int value) {
+  if (validPin(pin)) {
+    analogValues[pin] = value;
+  }
+}
+
+int hostPinWritten(int pin) {
+  return validPin(pin) ? pinsWritten[pin] : LOW;
+}
+
+void pinMode(int pin, int mode) {
+  (void)pin;
+  (void)mode;
+}
+
+int digitalRead(int pin) {
+  applySchedule();
+  return validPin(pin) ? pinValues[pin] : LOW;
+}
+
+void digitalWrite(int pin, int value) {
+  if (validPin(pin)) {
+    pinsWritten[pin] = value;
+  }
+}
+
+int analogRead(int pin) {
+  return validPin(pin) ? analogValues[pin] : 0;
+}
+
+void hostSetInterruptless(int pin, bool none) {
+  if (validPin(pin)) {
+    interruptless[pin] = none;
+  }
+}
+
+int digitalPinToInterrupt(int pin) {
+  return (validPin(pin) && !interruptless[pin]) ? pin : NOT_AN_INTERRUPT;
+}
+
+void attachInterrupt(int interrupt, void (*isr)(), int mode) {
+  if (validPin(interrupt)) {
+    pinISRs[interrupt] = isr;
+    pinISRModes[interrupt] = mode;
+  }
+}
+
+void detachInterrupt(int interrupt) {
+  if (validPin(interrupt)) {
+    pinISRs[interrupt] = NULL;
+  }
+}
+
+/************************************************************************************
+ * scheduled pin changes & standby
+ ************************************************************************************/
+bool hostSchedulePin(int pin, int value, uint64_t atMicros) {
+  if (!validPin(pin) || (scheduledCount >= kHostScheduledPins)) {
+    return false;
+  }
+  scheduled[scheduledCount].at = atMicros;
+  scheduled[scheduledCount].pin = pin;
+  scheduled[scheduledCount].value = value;
+  scheduledCount += 1;
+  return true;
+}
+
+static int nextScheduled() {                  // earliest entry, -1 if none
+  int next = -1;
+  for (int i=0; i<scheduledCount; i++) {
+    if ((next < 0) || (scheduled[i].at < scheduled[next].at)) {
+      next = i;
+    }
+  }
+  return next;
+}
+
+static bool firesInterrupt(int pin, int value) {
+  if ((pinISRs[pin] == NULL) || (pinValues[pin] == value)) {
+    return false;
+  }
+  int mode = pinISRModes[pin];
+  return (mode == CHANGE) || ((mode == RISING) && (value == HIGH)) || ((mode == FALLING) && (value == LOW));
+}
+
+// returns true if an interrupt handler was called
+static bool applyOne(int i) {
+  ScheduledPin change = scheduled[i];
+  scheduled[i] = scheduled[scheduledCount - 1];
+  scheduledCount -= 1;
+  bool fires = firesInterrupt(change.pin, change.value);
+  pinValues[change.pin] = change.value;
+  if (fires) {
+    pinISRs[change.pin]();
+  }
+  return fires;
+}
+
+static void applySchedule() {
+  int next;
+  while (((next = nextScheduled()) >= 0) && (scheduled[next].at <= virtualMicros)) {
+    applyOne(next);
+  }
+}
+
+bool hostStandby(uint64_t untilMicros) {
+  int next;
+  while (((next = nextScheduled()) >= 0) && (scheduled[next].at <= untilMicros)) {
+    if (scheduled[next].at > virtualMicros) {
+      virtualMicros = scheduled[next].at;
+    }
+    if (applyOne(next)) {
+      return true;
+    }
+  }
+  if (untilMicros > virtualMicros) {
+    virtualMicros = untilMicros;
+  }
+  return false;
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+/************************************************************************************
+ * Math; random() is a per thread xorshift so parallel runs are repeatable
+ ************************************************************************************/
+static uint32_t nextRandom() {
+  uint32_t x = randomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  randomState = x;
+  return x;
+}
+
+long random(long howBig) {
+  if (howBig <= 0) {
+    return 0;
+  }
+  return nextRandom() % howBig;
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig) {
+    return howSmall;
+  }
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  randomState = (seed != 0) ? uint32_t(seed) : 1;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) {
+    return outMin;
+  }
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+/************************************************************************************
+ * Print & Serial
+ ************************************************************************************/
+size_t Print::write(uint8_t c) {
+  (void)c;
+  return 1;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (n < size) {
+    n += write(buffer[n]);
+  }
+  return n;
+}
+
+int Print::availableForWrite() {
+  return 0;
+}
+
+size_t Print::print(const char *s) {
+  return write((const uint8_t *)s, strlen(s));
+}
+
+size_t Print::print(char c) {
+  return write(uint8_t(c));
+}
+
+size_t Print::print(long n, int base) {
+  if ((n < 0) && (base == DEC)) {
+    return print('-') + print((unsigned long)(-n), base);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), (base == HEX) ? "%lX" : "%lu", n);
+  return print(buffer);
+}
+
+size_t Print::print(double n, int digits) {
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return print(buffer);
+}
+
+size_t Print::println() {
+  return print("\n");                      // host line ending; Serial stays binary clean
+}
+
+void HostSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+void hostSerialEnabled(bool enabled) {
+  serialEnabled = enabled;
+}
+
+void hostSerialConnected(bool connected) {
+  serialConnected = connected;
+}
+
+HostSerial::operator bool() {
+  return serialConnected;
+}
+
+size_t HostSerial::write(uint8_t c) {
+  if (serialEnabled) {
+    putchar(c);
+  }
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size) {
+  if (serialEnabled) {
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+/************************************************************************************
+ * Adafruit_NeoPixel: same buffer layout as the library (GRB); show() takes as long
+ * as the real thing on the virtual clock
+ ************************************************************************************/
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, int type) {
+  (void)pin;
+  (void)type;
+  _numLEDs = n;
+  _pixels = (n > 0) ? (uint8_t *)calloc(n, 3) : NULL;
+  _brightness = 0;
+  _shows = 0;
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+  free(_pixels);
+}
+
+void Adafruit_NeoPixel::begin() {
+}
+
+void Adafruit_NeoPixel::show() {
+  virtualMicros += uint64_t(_numLEDs) * ws2812MicrosPerLED + ws2812LatchMicros;
+  _shows += 1;
+}
+
+bool Adafruit_NeoPixel::canShow() {
+  return true;
+}
+
+unsigned long Adafruit_NeoPixel::showCount() const {
+  return _shows;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, uint8_t(c >> 16), uint8_t(c >> 8), uint8_t(c));
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n >= _numLEDs) {
+    return;
+  }
+  if (_brightness) {
+    r = (r * _brightness) >> 8;
+    g = (g * _brightness) >> 8;
+    b = (b * _brightness) >> 8;
+  }
+  uint8_t *p = &_pixels[n*3];
+  p[0] = g;
+  p[1] = r;
+  p[2] = b;
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+  if (n >= _numLEDs) {
+    return 0;
+  }
+  const uint8_t *p = &_pixels[n*3];
+  return ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8) | p[2];
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if (first >= _numLEDs) {
+    return;
+  }
+  uint16_t end = ((count == 0) || (first + count > _numLEDs)) ? _numLEDs : first + count;
+  for (uint16_t i=first; i<end; i++) {
+    setPixelColor(i, c);
+  }
+}
+
+void Adafruit_NeoPixel::clear() {
+  if (_pixels) {
+    memset(_pixels, 0, _numLEDs*3);
+  }
+}
+
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  _brightness = b + 1;                // the library stores 0 as "not scaled"
+}
+
+uint8_t Adafruit_NeoPixel::getBrightness() const {
+  return _brightness - 1;
+}
+
+uint16_t Adafruit_NeoPixel::numPixels() const {
+  return _numLEDs;
+}
+
+uint8_t *Adafruit_NeoPixel::getPixels() const {
+  return _pixels;
+}
+
+/************************************************************************************
+ * Adafruit_DotStar
+ ************************************************************************************/
+Adafruit_DotStar::Adafruit_DotStar(uint16_t n, uint8_t dataPin, uint8_t clockPin, uint8_t order) {
+  (void)dataPin;
+  (void)clockPin;
+  (void)order;
+  _numLEDs = n;
+  _colors = (uint32_t *)calloc(n + 1, sizeof(uint32_t));
+}
+
+Adafruit_DotStar::Adafruit_DotStar(uint16_t n, uint8_t order) {
+  (void)order;
+  _numLEDs = n;
+  _colors = (uint32_t *)calloc(n + 1, sizeof(uint32_t));
+}
+
+Adafruit_DotStar::~Adafruit_DotStar() {
+  free(_colors);
+}
+
+void Adafruit_DotStar::show() {
+  virtualMicros += (uint64_t(_numLEDs) + 2) * dotStarNanosPerLED / 1000;   // + start & end frames
+}
+
+void Adafruit_DotStar::setPixelColor(uint16_t n, uint32_t c) {
+  if (n < _numLEDs) {
+    _colors[n] = c;
+  }
+}
+
+void Adafruit_DotStar::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  setPixelColor(n, ((uint32_t)r << 16) | ((uint32_t)g << 8) | b);
+}
+
+uint32_t Adafruit_DotStar::getPixelColor(uint16_t n) const {
+  return (n < _numLEDs) ? _colors[n] : 0;
+}
@@ -0,0 +1,59 @@
+/*!
+ * @file HostArduino.h
+ *
+ * @mainpage Host-only controls for the Arduino stand-in
+ *
+ * @section intro_sec Introduction
+ *
+ * Functions a simulation uses to drive the stand-in: move the virtual
+ * clock, set what digitalRead()/analogRead() return, and silence Serial.
+ * Everything here is per thread.
+ *
+ * Pin changes can also be scheduled for a virtual time; they happen as
+ * the clock passes that time, and call any attachInterrupt() handler
+ * whose edge they match. hostStandby() is the stand-in for the
+ * processor's standby mode: the clock jumps ahead to the wake time, or
+ * to the first scheduled change that fires an interrupt if sooner.
+ * Every pin has an interrupt unless hostSetInterruptless() says not.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * HostArduino.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef HostArduino_h
+#define HostArduino_h
+
+#include <stdint.h>
+
+#define kHostPins 32                // simulated GPIO pins
+#define kHostScheduledPins 32       // pin changes that can be waiting at once
+
+void hostSetMicros(uint64_t now);               // jump the virtual clock
+void hostAdvanceMicros(uint64_t us);            // move it forward
+uint64_t hostMicros();                          // full 64 bit virtual time
+void hostSetPin(int pin, int value);            // what digitalRead(pin) will return
+void hostSetAnalog(int pin, int value);         // what analogRead(pin) will return
+int hostPinWritten(int pin);                    // last digitalWrite(pin)
+void hostSerialEnabled(bool enabled);           // false -> Serial output discarded
+void hostSerialConnected(bool connected);       // what Serial (and USB) report; default true
+bool hostSchedulePin(int pin, int value, uint64_t atMicros);  // false if the schedule is full
+bool hostStandby(uint64_t untilMicros);         // true -> woken by an interrupt
+void hostSetInterruptless(int pin, bool none);  // true -> digitalPinToInterrupt(pin) is NOT_AN_INTERRUPT
+
+#endif
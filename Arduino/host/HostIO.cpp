@@ -0,0 +1,163 @@
+/*!
+ * @file HostIO.cpp
+ *
+ * @mainpage Host implementations of UDP and a file Print
+ *
+ * @section intro_sec Introduction
+ *
+ * POSIX sockets and stdio behind the Arduino interfaces.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * HostIO.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "HostIO.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+/************************************************************************************
+ * HostUDP
+ ************************************************************************************/
+HostUDP::HostUDP() {
+  _socket = -1;
+  _destinationPort = 0;
+  _length = 0;
+  _overflow = false;
+  _receivedLength = 0;
+  _receivedRead = 0;
+}
+
+HostUDP::~HostUDP() {
+  stop();
+}
+
+bool HostUDP::open() {
+  if (_socket < 0) {
+    _socket = socket(AF_INET, SOCK_DGRAM, 0);
+  }
+  return _socket >= 0;
+}
+
+uint8_t HostUDP::begin(uint16_t port) {
+  if (!open()) {
+    return 0;
+  }
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  return bind(_socket, (struct sockaddr *)&address, sizeof(address)) == 0;
+}
+
+void HostUDP::stop() {
+  if (_socket >= 0) {
+    ::close(_socket);
+    _socket = -1;
+  }
+}
+
+int HostUDP::beginPacket(IPAddress ip, uint16_t port) {
+  _destination = ip;
+  _destinationPort = port;
+  _length = 0;
+  _overflow = false;
+  return open();
+}
+
+size_t HostUDP::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HostUDP::write(const uint8_t *buffer, size_t size) {
+  if (_length + size > sizeof(_packet)) {
+    _overflow = true;
+    return 0;
+  }
+  memcpy(&_packet[_length], buffer, size);
+  _length += size;
+  return size;
+}
+
+int HostUDP::endPacket() {
+  if (_overflow || !open()) {
+    return 0;
+  }
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl((uint32_t(_destination[0]) << 24) | (uint32_t(_destination[1]) << 16) |
+                                  (uint32_t(_destination[2]) << 8) | _destination[3]);
+  address.sin_port = htons(_destinationPort);
+  ssize_t sent = sendto(_socket, _packet, _length, 0, (struct sockaddr *)&address, sizeof(address));
+  return sent == ssize_t(_length);
+}
+
+int HostUDP::parsePacket() {
+  if (_socket < 0) {
+    return 0;
+  }
+  ssize_t received = recv(_socket, _received, sizeof(_received), MSG_DONTWAIT);
+  _receivedLength = (received > 0) ? size_t(received) : 0;
+  _receivedRead = 0;
+  return int(_receivedLength);
+}
+
+int HostUDP::read(unsigned char *buffer, size_t length) {
+  size_t n = min(length, _receivedLength - _receivedRead);
+  memcpy(buffer, &_received[_receivedRead], n);
+  _receivedRead += n;
+  return int(n);
+}
+
+/************************************************************************************
+ * HostFile
+ ************************************************************************************/
+HostFile::HostFile() {
+  _file = NULL;
+}
+
+HostFile::~HostFile() {
+  close();
+}
+
+bool HostFile::open(const char *path) {
+  close();
+  _file = fopen(path, "wb");
+  return _file != NULL;
+}
+
+void HostFile::close() {
+  if (_file != NULL) {
+    fclose(_file);
+    _file = NULL;
+  }
+}
+
+size_t HostFile::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HostFile::write(const uint8_t *buffer, size_t size) {
+  if (_file == NULL) {
+    return 0;
+  }
+  return fwrite(buffer, 1, size, _file);
+}
@@ -0,0 +1,84 @@
+/*!
+ * @file HostIO.h
+ *
+ * @mainpage Host implementations of UDP and a file Print
+ *
+ * @section intro_sec Introduction
+ *
+ * HostUDP sends and receives real datagrams with POSIX sockets, so the
+ * network outputs can be pointed at 127.0.0.1 (or a real controller).
+ * HostFile is a Print that writes to a file, for FileOutput.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * HostIO.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef HostIO_h
+#define HostIO_h
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "Udp.h"
+
+#define kHostPacketBytes 1500
+
+/************************************************************************************
+ * packets are assembled in a buffer and sent by endPacket(), like WiFiUDP
+ ************************************************************************************/
+class HostUDP : public UDP {
+  public:
+    HostUDP();
+    ~HostUDP();
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(IPAddress ip, uint16_t port);
+    int endPacket();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    int parsePacket();
+    int read(unsigned char *buffer, size_t length);
+
+  private:
+    int _socket;
+    IPAddress _destination;
+    uint16_t _destinationPort;
+    uint8_t _packet[kHostPacketBytes];
+    size_t _length;                         // bytes in _packet
+    bool _overflow;                         // packet too big, endPacket() will fail
+    uint8_t _received[kHostPacketBytes];
+    size_t _receivedLength;
+    size_t _receivedRead;
+
+    bool open();
+};
+
+class HostFile : public Print {
+  public:
+    HostFile();
+    ~HostFile();
+    bool open(const char *path);            // truncates
+    void close();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+
+  private:
+    FILE *_file;
+};
+
+#endif
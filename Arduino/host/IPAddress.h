@@ -0,0 +1,45 @@
+/*!
+ * @file IPAddress.h
+ *
+ * @mainpage Host stand-in for the Arduino IPAddress class
+ *
+ * @section intro_sec Introduction
+ *
+ * IPv4 only, just what NetworkOutput needs.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * IPAddress.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef Host_IPAddress_h
+#define Host_IPAddress_h
+
+#include <stdint.h>
+
+class IPAddress {
+  public:
+    IPAddress() { _bytes[0] = _bytes[1] = _bytes[2] = _bytes[3] = 0; }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _bytes[0] = a; _bytes[1] = b; _bytes[2] = c; _bytes[3] = d; }
+    uint8_t operator[](int i) const { return _bytes[i]; }
+
+  private:
+    uint8_t _bytes[4];
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*!
+ * @file OutputBench.cpp
+ *
+ * @mainpage Host benchmark for the StripOutput backends
+ *
+ * @section intro_sec Introduction
+ *
+ * Runs the same render/show loop through each output and prints, per
+ * frame:
+ *  - the frame period and the time show() held up the loop, on the
+ *    virtual clock (what the microcontroller would see: NeoPixel blocks
+ *    for the whole transfer, DMA overlaps it with rendering)
+ *  - the real time this computer took in show(), i.e. the cost of
+ *    expanding and encoding the frame for that backend
+ * Rendering is charged a fixed virtual time per LED. The network outputs
+ * send to 127.0.0.1 and the packets are read back and counted. The file
+ * output writes to the path given as the first argument (/dev/null if
+ * none). See README.md for how to build it.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OutputBench.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+#include <Adafruit_DotStar.h>
+#include "AnimationGlobals.h"
+#include "PaletteFrame.h"
+#include "StripOutput.h"
+#include "DMAOutput.h"
+#include "NetworkOutput.h"
+#include "HostIO.h"
+#include <stdio.h>
+#include <chrono>
+
+#define benchFrames 500
+#define renderNanosPerLED 4000        // rough cost of drawing one LED on an M0
+
+const uint32_t indicatorColor = rgbColor(64, 0, 0);
+const uint32_t offColor = rgbColor(0, 0, 0);
+PaletteFrame frame = PaletteFrame(kNumberOfLEDs);
+
+static HostUDP receiver;              // plays the network controller
+static unsigned long bytesReceived;
+
+// stand-in for an animation step: change a few pixels and charge the render time
+static void render(int step) {
+  for (int i=0; i<kNumberOfLEDs; i+=7) {
+    frame.setPixelColor(i, ((i + step) & 1) ? indicatorColor : offColor);
+  }
+  hostAdvanceMicros(uint64_t(kNumberOfLEDs) * renderNanosPerLED / 1000);
+}
+
+static void drainReceiver() {
+  uint8_t packet[kHostPacketBytes];
+  while (receiver.parsePacket() > 0) {
+    bytesReceived += receiver.read(packet, sizeof(packet));
+  }
+}
+
+static void run(StripOutput &output) {
+  output.begin();
+  frame.setOutput(&output);
+  bytesReceived = 0;
+  uint64_t start = hostMicros();
+  uint64_t inShow = 0;
+  std::chrono::nanoseconds hostTime(0);
+  for (int step=0; step<benchFrames; step++) {
+    render(step);
+    uint64_t before = hostMicros();
+    auto hostBefore = std::chrono::steady_clock::now();
+    frame.show();
+    hostTime += std::chrono::steady_clock::now() - hostBefore;
+    inShow += hostMicros() - before;
+    drainReceiver();
+  }
+  uint64_t elapsed = hostMicros() - start;
+  double hostNanos = double(hostTime.count()) / benchFrames;
+  printf("%-9s %5d LEDs: %8.1f us/frame, %8.1f us blocked in show(); host %8.0f ns/frame (%6.0f LEDs/ms)",
+         output.name(), kNumberOfLEDs, double(elapsed) / benchFrames, double(inShow) / benchFrames,
+         hostNanos, kNumberOfLEDs * 1e6 / hostNanos);
+  if (bytesReceived) {
+    printf(", %lu bytes received", bytesReceived);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  Adafruit_NeoPixel pixels = Adafruit_NeoPixel(kNumberOfLEDs, 1, NEO_GRB + NEO_KHZ800);
+  Adafruit_DotStar dotStars = Adafruit_DotStar(kNumberOfLEDs, 2, 3);
+  NeoPixelOutput neoPixelOutput = NeoPixelOutput(pixels);
+  DotStarOutput dotStarOutput = DotStarOutput(dotStars);
+  DMAOutput *dmaOutput = new DMAOutput();     // the bitstream is big for a stack
+  HostUDP sender;
+  DDPOutput ddpOutput = DDPOutput(sender, IPAddress(127, 0, 0, 1));
+  E131Output e131Output = E131Output(sender, IPAddress(127, 0, 0, 1));
+  HostFile file;
+  FileOutput fileOutput = FileOutput(file);
+
+  const char *path = (argc > 1) ? argv[1] : "/dev/null";
+  if (!file.open(path)) {
+    printf("can't open %s\n", path);
+    return 1;
+  }
+  sender.begin(0);
+  frame.begin();
+  run(neoPixelOutput);
+  run(dotStarOutput);
+  run(*dmaOutput);
+  receiver.begin(kDDPPort);
+  run(ddpOutput);
+  receiver.stop();
+  receiver.begin(kE131Port);
+  run(e131Output);
+  run(fileOutput);
+  delete dmaOutput;
+  return 0;
+}
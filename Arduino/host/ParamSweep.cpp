@@ -0,0 +1,423 @@
+/*!
+ * @file ParamSweep.cpp
+ *
+ * @mainpage Host sweep of the stairway's timing parameters
+ *
+ * @section intro_sec Introduction
+ *
+ * minimumTraverseTime, maximumTraverseTime, the PIR debounce
+ * (stableStateMinimum) and the animation time were chosen by hand. This
+ * runs the real PIR debounce, StairMachine and Fader (as FadeToColor uses
+ * it) over one traffic trace for every combination of a grid of values,
+ * and ranks the combinations by
+ *  - missed traversals: people in the dark for more than missedDark ms
+ *    of their walk (dark being below a quarter brightness)
+ *  - dark while occupied: ms anyone was on the stairs in the dark
+ *  - energy: the light put out, as seconds of the whole strip at full
+ *    brightness
+ * in that order. The sketch's own settings are marked with a *.
+ *
+ * The trace is either synthetic (people arriving at random from either
+ * end, overlapping, plus the odd spurious PIR blip) or read from a file
+ * of lines
+ *   walker <start ms> <walk ms> top|bottom
+ *   blip <start ms> <length ms> top|bottom
+ * (# starts a comment), e.g. written from a site's event log.
+ *
+ * Each combination is a simulation of its own on a virtual clock; the
+ * host stand-ins keep the clock and the pins per thread, so the
+ * combinations are shared among worker threads, each stealing from the
+ * others' queues when its own runs out.
+ *
+ * usage: paramSweep [people | trace file] [threads]
+ *   (default 300 synthetic people, one thread per core)
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * ParamSweep.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "PaletteFrame.h"
+#include "PIR.h"
+#include "StairMachine.h"
+#include "Fader.h"
+#include "FadeAndWipe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#define loopTime 10                   // ms between loop()s
+#define topPin 0                      // as stairway.ino
+#define bottomPin 3
+#define pirHold PIRHoldMillis         // ms a PIR stays active after someone passes (StairMachine.h)
+#define meanArrival 20000             // ms between people, on average
+#define quickestWalk 3000             // ms to walk the stairs
+#define slowestWalk 10000
+#define meanBlip 600000               // ms between spurious PIR blips, on average
+#define longestBlip 150               // ms
+#define darkLevel 16384               // brightness below this is dark
+#define missedDark 1000               // ms in the dark that spoil someone's walk
+#define reportCount 15                // best combinations printed
+
+// the sketch's settings (StairMachine.h, PIR.h & FadeAndWipe.h), which the grid must include
+#define sketchMinTraverse uint32_t(minimumTraverseTime * 1000)
+#define sketchMaxTraverse uint32_t(maximumTraverseTime * 1000)
+#define sketchStableTime uint32_t(kStableStateMinimum)
+#define sketchFadeTime uint32_t(kFadeToColorTime * 1000 + 0.5)
+
+// the grid
+static constexpr uint32_t minTraverses[] = { 1000, 1500, 2000, 2500, 3000, 4000 };
+static constexpr uint32_t maxTraverses[] = { 6000, 8000, 10000, 12000, 15000, 20000, 25000, 30000 };
+static constexpr uint32_t stableTimes[] = { 30, 60, 100, 150, 200, 300 };
+static constexpr uint32_t fadeTimes[] = { 300, 500, 800, 1300, 2000, 3000 };
+
+template <size_t N>
+constexpr bool inGrid(const uint32_t (&table)[N], uint32_t value, size_t i=0) {
+  return (i < N) && ((table[i] == value) || inGrid(table, value, i + 1));
+}
+static_assert(inGrid(minTraverses, sketchMinTraverse) && inGrid(maxTraverses, sketchMaxTraverse) &&
+              inGrid(stableTimes, sketchStableTime) && inGrid(fadeTimes, sketchFadeTime),
+              "the grid doesn't include the sketch's settings");
+
+// PIR.cpp & PaletteFrame.cpp want these; the PIRs here have no indicators so
+// nothing is ever drawn
+const uint32_t indicatorColor = 0;
+const uint32_t offColor = 0;
+PaletteFrame frame = PaletteFrame(kNumberOfLEDs);
+
+struct Params {
+  uint32_t minTraverse;
+  uint32_t maxTraverse;
+  uint32_t stableTime;
+  uint32_t fadeTime;
+};
+
+struct Result {
+  int missed;
+  uint32_t darkOccupied;              // ms
+  uint32_t litEmpty;                  // ms
+  double energy;                      // s of the whole strip at full brightness
+  unsigned long dropped;
+};
+
+/************************************************************************************
+ * the traffic: people on the stairs from start to start+length, keeping the PIR
+ * they pass active for pirHold; blips are a PIR active for length with nobody there
+ ************************************************************************************/
+struct Passage {
+  uint32_t start;
+  uint32_t length;
+  bool fromTop;
+};
+
+struct Trace {
+  std::vector<Passage> walkers;       // in order of start
+  std::vector<Passage> blips;
+  uint32_t end;
+};
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom(uint32_t range) {
+  randomState = randomState * 1664525UL + 1013904223UL;
+  return (randomState >> 8) % range;
+}
+
+static void syntheticTrace(Trace &trace, int people) {
+  uint32_t start = 1000;
+  for (int i=0; i<people; i++) {
+    start += 100 + nextRandom(2*meanArrival);
+    trace.walkers.push_back({ start, quickestWalk + nextRandom(slowestWalk - quickestWalk), nextRandom(2) == 0 });
+  }
+  trace.end = start + slowestWalk + 30000;
+  for (uint32_t blip=nextRandom(2*meanBlip); blip<trace.end; blip+=1 + nextRandom(2*meanBlip)) {
+    trace.blips.push_back({ blip, 1 + nextRandom(longestBlip), nextRandom(2) == 0 });
+  }
+}
+
+static bool readTrace(Trace &trace, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return false;
+  }
+  char line[128];
+  trace.end = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    char kind[16];
+    char end[16];
+    unsigned long start;
+    unsigned long length;
+    if ((line[0] == '#') || (sscanf(line, "%15s %lu %lu %15s", kind, &start, &length, end) != 4)) {
+      continue;
+    }
+    Passage passage = { uint32_t(start), uint32_t(length), strcmp(end, "top") == 0 };
+    if (strcmp(kind, "walker") == 0) {
+      trace.walkers.push_back(passage);
+    } else if (strcmp(kind, "blip") == 0) {
+      trace.blips.push_back(passage);
+    }
+    trace.end = max(trace.end, uint32_t(start + length));
+  }
+  fclose(file);
+  std::sort(trace.walkers.begin(), trace.walkers.end(),
+            [](const Passage &a, const Passage &b) { return a.start < b.start; });
+  trace.end += slowestWalk + 30000;
+  return !trace.walkers.empty();
+}
+
+/************************************************************************************
+ * the lights as FadeToColor does them: fade up from black when the stairs light,
+ * down from wherever it got to when they go off
+ ************************************************************************************/
+class FadeHandler : public StairHandler {
+  public:
+    FadeHandler(uint32_t fadeTime) : _fadeTime(fadeTime) {}
+    void lightsOn(bool fromTop, uint32_t now) {
+      (void)fromTop;
+      _fader.start(0, 65535, _fadeTime, fadeSine, now);
+    }
+    void lightsOff(bool fromTop, uint32_t now) {
+      (void)fromTop;
+      _fader.start(_fader.level(now), 0, _fadeTime, fadeSine, now);
+    }
+    uint16_t level(uint32_t now) {
+      return _fader.level(now);
+    }
+
+  private:
+    uint32_t _fadeTime;
+    Fader _fader;
+};
+
+static bool passing(uint32_t now, uint32_t passed, uint32_t hold) {
+  return (now >= passed) && (now - passed < hold);
+}
+
+// one combination, on this thread's virtual clock and pins
+static Result simulate(const Params &params, const Trace &trace) {
+  hostSetMicros(0);
+  hostSetPin(topPin, LOW);
+  hostSetPin(bottomPin, LOW);
+  PIR topPIR = PIR(topPin, -1, "top");
+  PIR bottomPIR = PIR(bottomPin, -1, "bottom");
+  topPIR.setStableTime(params.stableTime);
+  bottomPIR.setStableTime(params.stableTime);
+  FadeHandler handler = FadeHandler(params.fadeTime);
+  StairMachine machine = StairMachine(handler, params.minTraverse, params.maxTraverse);
+  const std::vector<Passage> &walkers = trace.walkers;
+  std::vector<uint32_t> dark(walkers.size(), 0);   // ms each person spent in the dark
+  Result result = { 0, 0, 0, 0, 0 };
+  uint64_t levelSum = 0;              // level * ms
+  size_t first = 0;                   // walkers before this are long gone
+  size_t nextBlip = 0;
+  for (uint32_t now=0; now<trace.end; now+=loopTime) {
+    hostSetMicros(uint64_t(now) * 1000);
+    bool top = false;
+    bool bottom = false;
+    while ((first < walkers.size()) && (walkers[first].start + walkers[first].length + pirHold < now)) {
+      first += 1;
+    }
+    while ((nextBlip < trace.blips.size()) && (trace.blips[nextBlip].start + trace.blips[nextBlip].length < now)) {
+      nextBlip += 1;
+    }
+    for (size_t i=nextBlip; (i<trace.blips.size()) && (trace.blips[i].start <= now); i++) {
+      bool &pir = trace.blips[i].fromTop ? top : bottom;
+      pir = pir || passing(now, trace.blips[i].start, trace.blips[i].length);
+    }
+    uint16_t level = handler.level(now);
+    int onStairs = 0;
+    bool anyDark = false;
+    for (size_t i=first; (i<walkers.size()) && (walkers[i].start <= now); i++) {
+      bool &entry = walkers[i].fromTop ? top : bottom;
+      bool &exit = walkers[i].fromTop ? bottom : top;
+      entry = entry || passing(now, walkers[i].start, pirHold);
+      exit = exit || passing(now, walkers[i].start + walkers[i].length, pirHold);
+      if (now - walkers[i].start < walkers[i].length) {
+        onStairs += 1;
+        if (level < darkLevel) {
+          dark[i] += loopTime;
+          anyDark = true;
+        }
+      }
+    }
+    hostSetPin(topPin, top ? HIGH : LOW);
+    hostSetPin(bottomPin, bottom ? HIGH : LOW);
+    machine.update(topPIR.read(), bottomPIR.read(), now);
+    levelSum += uint64_t(level) * loopTime;
+    if (anyDark) {
+      result.darkOccupied += loopTime;
+    }
+    if ((onStairs == 0) && (level > 0)) {
+      result.litEmpty += loopTime;
+    }
+  }
+  for (size_t i=0; i<walkers.size(); i++) {
+    result.missed += (dark[i] > missedDark) ? 1 : 0;
+  }
+  result.energy = double(levelSum) / 65535.0 / 1000.0;
+  result.dropped = machine.dropped();
+  return result;
+}
+
+/************************************************************************************
+ * a queue of task numbers per worker; a worker takes from the back of its own and,
+ * when that's empty, from the front of someone else's
+ ************************************************************************************/
+class StealingPool {
+  public:
+    StealingPool(int workers) : _queues(workers) {}
+
+    void run(int tasks, const std::function<void(int)> &work) {
+      for (int t=0; t<tasks; t++) {
+        _queues[t % _queues.size()].tasks.push_back(t);
+      }
+      std::vector<std::thread> threads;
+      for (size_t w=0; w<_queues.size(); w++) {
+        threads.emplace_back([this, w, &work]() { serve(w, work); });
+      }
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+    }
+
+  private:
+    struct Queue {
+      std::mutex lock;
+      std::deque<int> tasks;
+    };
+    std::vector<Queue> _queues;
+
+    bool take(size_t w, bool own, int &task) {
+      std::lock_guard<std::mutex> guard(_queues[w].lock);
+      std::deque<int> &tasks = _queues[w].tasks;
+      if (tasks.empty()) {
+        return false;
+      }
+      if (own) {
+        task = tasks.back();
+        tasks.pop_back();
+      } else {
+        task = tasks.front();
+        tasks.pop_front();
+      }
+      return true;
+    }
+
+    // nothing adds tasks once they're running, so when every queue is empty we're done
+    void serve(size_t w, const std::function<void(int)> &work) {
+      hostSerialEnabled(false);
+      int task;
+      for (;;) {
+        bool found = take(w, true, task);
+        for (size_t v=1; !found && (v<_queues.size()); v++) {
+          found = take((w + v) % _queues.size(), false, task);
+        }
+        if (!found) {
+          return;
+        }
+        work(task);
+      }
+    }
+};
+
+#define gridCount(table) int(sizeof(table)/sizeof(table[0]))
+
+static Params paramsFor(int n) {
+  Params params;
+  params.fadeTime = fadeTimes[n % gridCount(fadeTimes)];
+  n /= gridCount(fadeTimes);
+  params.stableTime = stableTimes[n % gridCount(stableTimes)];
+  n /= gridCount(stableTimes);
+  params.maxTraverse = maxTraverses[n % gridCount(maxTraverses)];
+  n /= gridCount(maxTraverses);
+  params.minTraverse = minTraverses[n];
+  return params;
+}
+
+static bool better(const Result &a, const Result &b) {
+  if (a.missed != b.missed) {
+    return a.missed < b.missed;
+  }
+  if (a.darkOccupied != b.darkOccupied) {
+    return a.darkOccupied < b.darkOccupied;
+  }
+  return a.energy < b.energy;
+}
+
+static bool sketchSettings(const Params &params) {
+  return (params.minTraverse == sketchMinTraverse) && (params.maxTraverse == sketchMaxTraverse) &&
+         (params.stableTime == sketchStableTime) && (params.fadeTime == sketchFadeTime);
+}
+
+static void printRow(int rank, const Params &params, const Result &result) {
+  printf("%5d%s %6lu %6lu %5lu %5lu %7d %9.1f %9.1f %10.1f\n", rank, sketchSettings(params) ? "*" : " ",
+         (unsigned long)params.minTraverse, (unsigned long)params.maxTraverse,
+         (unsigned long)params.stableTime, (unsigned long)params.fadeTime, result.missed,
+         result.darkOccupied / 1000.0, result.litEmpty / 1000.0, result.energy);
+}
+
+int main(int argc, char **argv) {
+  hostSerialEnabled(false);
+  Trace trace;
+  if ((argc > 1) && (atoi(argv[1]) == 0)) {
+    if (!readTrace(trace, argv[1])) {
+      printf("no walkers in %s\n", argv[1]);
+      return 1;
+    }
+  } else {
+    syntheticTrace(trace, (argc > 1) ? atoi(argv[1]) : 300);
+  }
+  int threads = (argc > 2) ? atoi(argv[2]) : int(std::thread::hardware_concurrency());
+  threads = max(threads, 1);
+  int combinations = gridCount(minTraverses) * gridCount(maxTraverses) * gridCount(stableTimes) * gridCount(fadeTimes);
+  std::vector<Result> results(combinations);
+  auto started = std::chrono::steady_clock::now();
+  StealingPool pool = StealingPool(threads);
+  pool.run(combinations, [&](int n) { results[n] = simulate(paramsFor(n), trace); });
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+  std::vector<int> order(combinations);
+  for (int n=0; n<combinations; n++) {
+    order[n] = n;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return better(results[a], results[b]); });
+  unsigned long dropped = 0;
+  for (const Result &result : results) {
+    dropped += result.dropped;
+  }
+  printf("%zu walkers, %zu blips, %lu s of traffic; %d combinations on %d threads in %.1f s; %lu events dropped\n",
+         trace.walkers.size(), trace.blips.size(), (unsigned long)(trace.end / 1000), combinations, threads,
+         seconds, dropped);
+  printf("%5s  %6s %6s %5s %5s %7s %9s %9s %10s\n", "rank", "min", "max", "pir", "fade", "missed",
+         "dark (s)", "empty (s)", "energy (s)");
+  for (int r=0; r<combinations; r++) {
+    const Params params = paramsFor(order[r]);
+    if ((r < reportCount) || sketchSettings(params)) {
+      printRow(r+1, params, results[order[r]]);
+    }
+  }
+  return (dropped == 0) ? 0 : 1;
+}
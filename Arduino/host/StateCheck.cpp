@@ -0,0 +1,305 @@
+/*!
+ * @file StateCheck.cpp
+ *
+ * @mainpage Host check of the stairway state machine
+ *
+ * @section intro_sec Introduction
+ *
+ * Runs StairMachine through every sequence of a few PIR edges (either
+ * PIR, at a handful of spacings chosen around the traverse times) on the
+ * virtual clock, calling update() every loopTime ms as loop() would, and
+ * checks that:
+ *  - motion while the stairs are dark lights them within one loop
+ *  - the lights never go off while a PIR is active
+ *  - once both PIRs are quiet the lights go off and the machine is idle
+ *    again within the longest traverse time
+ *  - the event queue never overflows
+ * It prints the number of sequences, the worst light latency and the
+ * first few sequences that break a rule. The latency is the machine's
+ * alone; on the board the PIR debounce (100 ms) comes before it.
+ *
+ * With "walkers" it instead sends people up and down the stairs at random
+ * (overlapping, from both ends), drives the PIRs from where they are, and
+ * reports how long someone was on the stairs in the dark and how long the
+ * lights were on with nobody there. Two PIRs can't tell someone arriving
+ * at an end from someone leaving by it, so when two people cross (one
+ * setting off from the end the other is walking to) the lights can go
+ * off early; it fails if that leaves more than darkPerWalker ms of
+ * darkness per walker, on average.
+ *
+ * usage: stateCheck [edges]   (default 5 edges; each one more is 8 times the work)
+ *        stateCheck walkers [people]   (default 2000)
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * StateCheck.cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#include "Arduino.h"
+#include "StairMachine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define loopTime 10                   // ms between update() calls
+#define edgeOffset 3                  // edges land between loops, not on them
+#define maxEdges 8
+#define reportLimit 5                 // failing sequences printed
+
+static const uint32_t gaps[] = { 50, 3000, 9500, 16000 };    // ms before each edge
+#define gapCount 4
+#define choices (2*gapCount)          // which PIR x which gap
+
+#define pirHold PIRHoldMillis         // ms a PIR stays active after someone passes (StairMachine.h)
+#define meanArrival 60000             // ms between people, on average
+#define quickestWalk 3000             // ms to walk the stairs
+#define slowestWalk 10000
+#define darkPerWalker (2*loopTime)    // ms dark while occupied allowed per walker, on average
+
+static bool top = false;              // PIR levels, as the machine is told them
+static bool bottom = false;
+
+/************************************************************************************
+ * stands in for the lights, checking what it's asked to do
+ ************************************************************************************/
+class CheckHandler : public StairHandler {
+  public:
+    bool lit;
+    bool litOverTime;                 // motion was left dark for more than a loop
+    bool offWhileActive;
+    uint32_t darkSince;               // when motion was first seen in the dark
+    bool waiting;                     // for the lights after darkSince
+    uint32_t worstLatency;
+
+    void reset() {
+      lit = false;
+      litOverTime = false;
+      offWhileActive = false;
+      waiting = false;
+      darkSince = 0;
+    }
+    void motion(uint32_t now) {       // a PIR went active
+      if (!lit && !waiting) {
+        waiting = true;
+        darkSince = now;
+      }
+    }
+    void check(uint32_t now) {
+      if (waiting && ((now - darkSince) > loopTime)) {
+        litOverTime = true;
+      }
+    }
+    void lightsOn(bool fromTop, uint32_t now) {
+      (void)fromTop;
+      lit = true;
+      if (waiting) {
+        worstLatency = max(worstLatency, now - darkSince);
+        waiting = false;
+      }
+    }
+    void lightsOff(bool fromTop, uint32_t now) {
+      (void)fromTop;
+      (void)now;
+      if (top || bottom) {
+        offWhileActive = true;
+      }
+      lit = false;
+    }
+};
+
+static CheckHandler handler;
+
+// loop() until the virtual clock reaches until
+static void runUntil(StairMachine &machine, uint64_t until) {
+  while (hostMicros() + uint64_t(loopTime)*1000 <= until) {
+    hostAdvanceMicros(uint64_t(loopTime)*1000);
+    uint32_t now = millis();
+    machine.update(top, bottom, now);
+    handler.check(now);
+  }
+}
+
+static void printSequence(unsigned long sequence, int edges) {
+  for (int e=0; e<edges; e++) {
+    int choice = sequence % choices;
+    sequence /= choices;
+    printf(" +%lums %s", (unsigned long)gaps[choice % gapCount], (choice < gapCount) ? "top" : "bottom");
+  }
+}
+
+// returns true if the sequence broke a rule
+static bool runSequence(unsigned long sequence, int edges, unsigned long &dropped) {
+  StairMachine machine = StairMachine(handler, minimumTraverseTime*1000UL, maximumTraverseTime*1000UL);
+  top = false;
+  bottom = false;
+  handler.reset();
+  hostSetMicros(0);
+  uint64_t edgeTime = 0;
+  unsigned long rest = sequence;
+  for (int e=0; e<edges; e++) {
+    int choice = rest % choices;
+    rest /= choices;
+    edgeTime += uint64_t(gaps[choice % gapCount] + edgeOffset) * 1000;
+    runUntil(machine, edgeTime);
+    hostSetMicros(edgeTime);
+    bool &pir = (choice < gapCount) ? top : bottom;
+    pir = !pir;
+    if (pir) {
+      handler.motion(uint32_t(edgeTime / 1000));
+    }
+  }
+  runUntil(machine, edgeTime + 1000000);    // a second for the last edge to be served
+  top = false;                              // everyone leaves
+  bottom = false;
+  edgeTime = hostMicros();
+  runUntil(machine, edgeTime + uint64_t(maximumTraverseTime*1000UL + 2*loopTime) * 1000);
+  dropped += machine.dropped();
+  bool stuck = handler.lit || !machine.idle();
+  return handler.litOverTime || handler.offWhileActive || stuck || (machine.dropped() != 0);
+}
+
+static int checkSequences(int edges) {
+  edges = constrain(edges, 1, maxEdges);
+  unsigned long sequences = 1;
+  for (int e=0; e<edges; e++) {
+    sequences *= choices;
+  }
+  handler.worstLatency = 0;
+  unsigned long failures = 0;
+  unsigned long dropped = 0;
+  for (unsigned long sequence=0; sequence<sequences; sequence++) {
+    if (runSequence(sequence, edges, dropped)) {
+      failures += 1;
+      if (failures <= reportLimit) {
+        printf("fails:%s%s%s\n", handler.litOverTime ? " (left dark)" : "",
+               handler.offWhileActive ? " (off while active)" : "",
+               handler.lit ? " (stuck on)" : "");
+        printSequence(sequence, edges);
+        printf("\n");
+      }
+    }
+  }
+  printf("%lu sequences of %d PIR edges: %lu failed, worst light latency %lu ms (update every %d ms), %lu events dropped\n",
+         sequences, edges, failures, (unsigned long)handler.worstLatency, loopTime, dropped);
+  return (failures == 0) ? 0 : 1;
+}
+
+/************************************************************************************
+ * walkers: each person is on the stairs from start to start+walk, and keeps the PIR
+ * they pass active for pirHold after passing it
+ ************************************************************************************/
+struct Walker {
+  uint32_t start;
+  uint32_t walk;
+  bool fromTop;
+  bool hidden;                        // set off while their PIR was already active
+};
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom(uint32_t range) {
+  randomState = randomState * 1664525UL + 1013904223UL;
+  return (randomState >> 8) % range;
+}
+
+static bool passing(uint32_t now, uint32_t passed) {
+  return (now >= passed) && (now - passed < pirHold);
+}
+
+static int checkWalkers(int people) {
+  Walker *walkers = new Walker[people];
+  uint32_t start = 1000;
+  for (int i=0; i<people; i++) {
+    start += 100 + nextRandom(2*meanArrival);
+    walkers[i].start = start;
+    walkers[i].walk = quickestWalk + nextRandom(slowestWalk - quickestWalk);
+    walkers[i].fromTop = nextRandom(2) == 0;
+    walkers[i].hidden = false;
+  }
+  StairMachine machine = StairMachine(handler, minimumTraverseTime*1000UL, maximumTraverseTime*1000UL);
+  top = false;
+  bottom = false;
+  handler.reset();
+  hostSetMicros(0);
+  uint32_t end = start + slowestWalk + maximumTraverseTime*1000UL;
+  uint32_t darkOccupied = 0;          // ms someone was on the stairs in the dark
+  uint32_t darkHidden = 0;            // the same, but they couldn't be seen coming
+  uint32_t litEmpty = 0;              // ms lit with nobody there
+  uint32_t occupiedTime = 0;
+  int overlapped = 0;                 // people who shared the stairs
+  int first = 0;                      // walkers before this are long gone
+  for (uint32_t now=0; now<end; now+=loopTime) {
+    hostSetMicros(uint64_t(now) * 1000);
+    bool wasTop = top;
+    bool wasBottom = bottom;
+    top = false;
+    bottom = false;
+    int onStairs = 0;
+    int seen = 0;                     // on the stairs & not hidden
+    while ((first < people) && (walkers[first].start + walkers[first].walk + pirHold < now)) {
+      first += 1;
+    }
+    for (int i=first; (i<people) && (walkers[i].start <= now); i++) {
+      bool &entry = walkers[i].fromTop ? top : bottom;
+      bool &exit = walkers[i].fromTop ? bottom : top;
+      entry = entry || passing(now, walkers[i].start);
+      exit = exit || passing(now, walkers[i].start + walkers[i].walk);
+      if (now - walkers[i].start < loopTime) {
+        walkers[i].hidden = walkers[i].fromTop ? wasTop : wasBottom;
+      }
+      if (now - walkers[i].start < walkers[i].walk) {
+        onStairs += 1;
+        seen += walkers[i].hidden ? 0 : 1;
+      }
+    }
+    machine.update(top, bottom, now);
+    if (onStairs > 0) {
+      occupiedTime += loopTime;
+      if (!handler.lit && (seen > 0)) {
+        darkOccupied += loopTime;
+      } else if (!handler.lit) {
+        darkHidden += loopTime;
+      }
+    } else if (handler.lit) {
+      litEmpty += loopTime;
+    }
+    if (onStairs > 1) {
+      overlapped += 1;
+    }
+  }
+  delete[] walkers;
+  printf("%d walkers, %lu s on the stairs (%d loops shared): %lu ms dark while occupied "
+         "(+%lu ms by people who set off under an active PIR), %lu ms lit while empty (%lu ms each), "
+         "%lu events dropped\n",
+         people, (unsigned long)(occupiedTime / 1000), overlapped, (unsigned long)darkOccupied,
+         (unsigned long)darkHidden, (unsigned long)litEmpty, (unsigned long)(litEmpty / people),
+         machine.dropped());
+  bool tooDark = (darkOccupied + darkHidden) > uint32_t(people) * darkPerWalker;
+  if (tooDark) {
+    printf("more than %d ms dark per walker\n", darkPerWalker);
+  }
+  return ((machine.dropped() == 0) && !tooDark) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  hostSerialEnabled(false);
+  if ((argc > 1) && (strcmp(argv[1], "walkers") == 0)) {
+    return checkWalkers((argc > 2) ? atoi(argv[2]) : 2000);
+  }
+  return checkSequences((argc > 1) ? atoi(argv[1]) : 5);
+}
@@ -0,0 +1,49 @@
+/*!
+ * @file Udp.h
+ *
+ * @mainpage Host stand-in for the Arduino UDP interface
+ *
+ * @section intro_sec Introduction
+ *
+ * The abstract UDP class that WiFiUDP, EthernetUDP etc. implement, cut
+ * down to what NetworkOutput uses. HostIO.h has a socket based version.
+ *
+ * @section author Author
+ *
+ * Written by Jim Calvin.
+ *
+ * @section license License
+ *
+ * This file is part of the project Stairway, an Arduino sketch to light
+ * a stairway using two PIR sensors and a NeoPixel strip. This software
+ * is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Udp.h is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ */
+
+#ifndef Host_Udp_h
+#define Host_Udp_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+class UDP : public Print {
+  public:
+    virtual uint8_t begin(uint16_t port) = 0;   // 0 -> any free port
+    virtual void stop() = 0;
+    virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+    virtual int endPacket() = 0;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    virtual int parsePacket() = 0;              // size of the next packet, 0 if none
+    virtual int read(unsigned char *buffer, size_t length) = 0;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# decodeLog.py - turn the binary records sent by EventLog::drain() back into text
+#
+# usage: decodeLog.py [capture file]       (reads stdin without one)
+#   e.g. cat /dev/ttyACM0 | python3 decodeLog.py
+#
+# The event names and texts come from LogEvents.h, so the order there must match
+# the sketch that made the capture. Bytes that aren't part of a record (the start
+# up text, say) are passed through unchanged; TraceLog records are left out.
+#
+# This file is part of the project Stairway; see EventLog.h for the license.
+
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+TRACESYNC = 0x5A                          # TraceLog's records, for traceToChrome.py
+RECORDBYTES = 12
+FRAMEBYTES = RECORDBYTES + 2
+
+def readEvents(path):
+    events = []
+    entry = re.compile(r'^\s*LOG_EVENT_ENTRY\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+    with open(path) as source:
+        for line in source:
+            match = entry.match(line)
+            if match:
+                events.append((match.group(1), match.group(2)))
+    return events
+
+def frameCheck(frame):
+    check = 0
+    for aByte in frame[1:1 + RECORDBYTES]:
+        check ^= aByte
+    return check == frame[FRAMEBYTES - 1]
+
+class Decoder(object):
+
+    def __init__(self, events, out):
+        self.events = events
+        self.out = out
+        self.lastMicros = None
+        self.wraps = 0
+        self.text = bytearray()
+        self.pending = bytearray()        # undecoded bytes, a frame's worth at most
+
+    def flushText(self):
+        if self.text:
+            self.out.write(self.text.decode('utf-8', 'replace'))
+            self.text = bytearray()
+
+    # micros() wraps every 71 minutes; keep counting up across the wraps
+    def unwrap(self, micros):
+        if (self.lastMicros is not None) and (micros < self.lastMicros) and (self.lastMicros - micros > 0x80000000):
+            self.wraps += 1
+        self.lastMicros = micros
+        return (self.wraps << 32) + micros
+
+    def record(self, frame):
+        micros, event, a, b = struct.unpack('<IHhi', bytes(frame[1:1 + RECORDBYTES]))
+        seconds = self.unwrap(micros) / 1000000.0
+        if event < len(self.events):
+            name, text = self.events[event]
+            message = text.replace('{a}', str(a)).replace('{b}', str(b))
+        else:
+            name = 'event%d' % event
+            message = 'a %d b %d' % (a, b)
+        self.flushText()
+        self.out.write('%12.6f %-20s %s\n' % (seconds, name, message))
+
+    # a frame only counts if its check byte is right; otherwise the sync byte was
+    # just text (or noise) and decoding carries on from the next byte. A sync byte
+    # too near the end of what's arrived waits for the rest
+    def feed(self, data):
+        data = self.pending + data
+        i = 0
+        while i < len(data):
+            if (data[i] == SYNC) or (data[i] == TRACESYNC):
+                if i + FRAMEBYTES > len(data):
+                    break
+                if frameCheck(data[i:i + FRAMEBYTES]):
+                    if data[i] == SYNC:
+                        self.record(data[i:i + FRAMEBYTES])
+                    i += FRAMEBYTES
+                    continue
+            self.text.append(data[i])
+            if data[i] == 0x0A:
+                self.flushText()
+            i += 1
+        self.pending = data[i:]
+        self.out.flush()
+
+    def finish(self):
+        self.text += self.pending
+        self.pending = bytearray()
+        self.flushText()
+        self.out.flush()
+
+    def decode(self, data):
+        self.feed(data)
+        self.finish()
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    events = readEvents(os.path.join(here, '..', 'LogEvents.h'))
+    decoder = Decoder(events, sys.stdout)
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], 'rb') as capture:
+            decoder.decode(bytearray(capture.read()))
+        return
+    while True:                           # as it arrives, for a live Serial port
+        data = os.read(sys.stdin.fileno(), 4096)
+        if not data:
+            break
+        decoder.feed(bytearray(data))
+    decoder.finish()
+
+if __name__ == '__main__':
+    main()
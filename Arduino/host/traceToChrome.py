@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+# traceToChrome.py - turn the records sent by TraceLog (and EventLog) into Chrome trace JSON
+#
+# usage: traceToChrome.py [capture file [json file]]   (stdin & stdout without them)
+#   e.g. cat /dev/ttyACM0 > capture.bin, then traceToChrome.py capture.bin trace.json
+#   and open trace.json in chrome://tracing or ui.perfetto.dev
+#
+# The span names come from TraceSpans.h and the event texts from LogEvents.h, so
+# the order in both must match the sketch that made the capture. Everything is
+# drawn on one timeline: each track in TraceSpans.h is a row, EventLog records go
+# on a "log" row. A span that began before a capture's ring starts has no begin
+# and is left out; one still going at the end of a capture is ended there.
+# Bytes that aren't records (the start up text, say) are ignored.
+#
+# This file is part of the project Stairway; see TraceLog.h for the license.
+
+import json
+import os
+import re
+import struct
+import sys
+
+import decodeLog
+
+TRACESYNC = 0x5A
+RECORDBYTES = 12
+FRAMEBYTES = RECORDBYTES + 2
+PID = 1
+
+def readSpans(path):
+    spans = []
+    entry = re.compile(r'^\s*TRACE_SPAN_ENTRY\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+    with open(path) as source:
+        for line in source:
+            match = entry.match(line)
+            if match:
+                spans.append((match.group(1), match.group(2), match.group(3)))
+    return spans
+
+# micros() wraps every 71 minutes; keep counting up across the wraps
+class Clock(object):
+
+    def __init__(self):
+        self.last = None
+        self.wraps = 0
+
+    def unwrap(self, micros):
+        if (self.last is not None) and (micros < self.last) and (self.last - micros > 0x80000000):
+            self.wraps += 1
+        self.last = micros
+        return (self.wraps << 32) + micros
+
+class Converter(object):
+
+    def __init__(self, spans, events):
+        self.spans = spans
+        self.events = events
+        self.traceClock = Clock()
+        self.logClock = Clock()
+        self.output = []
+        self.tids = {}
+        self.open = {}                    # tid -> names of the spans begun, innermost last
+        self.lastTime = 0
+
+    def tid(self, name):
+        if name not in self.tids:
+            self.tids[name] = len(self.tids) + 1
+            self.output.append({'name': 'thread_name', 'ph': 'M', 'pid': PID, 'tid': self.tids[name],
+                                'args': {'name': name}})
+        return self.tids[name]
+
+    def endOpen(self, time):
+        for tid, names in self.open.items():
+            while names:
+                self.output.append({'name': names.pop(), 'ph': 'E', 'ts': time, 'pid': PID, 'tid': tid})
+
+    def trace(self, frame):
+        micros, span, phase, track, arg = struct.unpack('<IBBhi', bytes(frame[1:1 + RECORDBYTES]))
+        time = self.traceClock.unwrap(micros)
+        if span < len(self.spans):
+            symbol, name, trackName = self.spans[span]
+        else:
+            symbol, name, trackName = 'span%d' % span, 'span%d' % span, 'unknown'
+        if symbol == 'trCapture':         # sent before a capture's ring, so it ends the previous one
+            self.endOpen(self.lastTime)
+            self.output.append({'name': 'capture of %d records' % arg, 'ph': 'i', 's': 'g', 'ts': time,
+                                'pid': PID, 'tid': self.tid(trackName)})
+            return
+        self.lastTime = time
+        tid = self.tid(trackName.replace('{track}', str(track)))
+        phase = chr(phase)
+        names = self.open.setdefault(tid, [])
+        event = {'name': name, 'ph': phase, 'ts': time, 'pid': PID, 'tid': tid}
+        if phase == 'B':
+            names.append(name)
+        elif phase == 'E':
+            if name not in names:         # began before the capture
+                return
+            while names and (names[-1] != name):
+                self.output.append({'name': names.pop(), 'ph': 'E', 'ts': time, 'pid': PID, 'tid': tid})
+            names.pop()
+            event['args'] = {'value': arg}
+        else:
+            event['s'] = 't'
+            event['args'] = {'value': arg}
+        self.output.append(event)
+
+    def log(self, frame):
+        micros, event, a, b = struct.unpack('<IHhi', bytes(frame[1:1 + RECORDBYTES]))
+        time = self.logClock.unwrap(micros)
+        if event < len(self.events):
+            name, text = self.events[event]
+            message = text.replace('{a}', str(a)).replace('{b}', str(b))
+        else:
+            name = 'event%d' % event
+            message = 'a %d b %d' % (a, b)
+        self.output.append({'name': name, 'ph': 'i', 's': 't', 'ts': time, 'pid': PID, 'tid': self.tid('log'),
+                            'args': {'message': message}})
+
+    def convert(self, data):
+        i = 0
+        while i < len(data):
+            if (i + FRAMEBYTES <= len(data)) and decodeLog.frameCheck(data[i:i + FRAMEBYTES]):
+                if data[i] == TRACESYNC:
+                    self.trace(data[i:i + FRAMEBYTES])
+                    i += FRAMEBYTES
+                    continue
+                if data[i] == decodeLog.SYNC:
+                    self.log(data[i:i + FRAMEBYTES])
+                    i += FRAMEBYTES
+                    continue
+            i += 1
+        self.endOpen(self.lastTime)
+        return {'traceEvents': self.output, 'displayTimeUnit': 'ms'}
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    spans = readSpans(os.path.join(here, '..', 'TraceSpans.h'))
+    events = decodeLog.readEvents(os.path.join(here, '..', 'LogEvents.h'))
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], 'rb') as capture:
+            data = capture.read()
+    else:
+        data = sys.stdin.buffer.read()
+    trace = Converter(spans, events).convert(bytearray(data))
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], 'w') as out:
+            json.dump(trace, out)
+    else:
+        json.dump(trace, sys.stdout)
+
+if __name__ == '__main__':
+    main()
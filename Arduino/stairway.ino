@@ -19,9 +19,13 @@
  * This file depends on multiple Adafruit library and board definitions
  * 
  * This project also requires the following files:
- * Animation.cpp/.h, AnimationGlobals.h, ColorSwirl.cpp/.h,
- * FadeAndWipe.cpp/.h, PIR.cpp/.h, Twinkle.cpp/.h,
- * ZipLine.cpp/.h
+ * Animation.cpp/.h, AnimationArena.cpp/.h, AnimationGlobals.h, ColorSwirl.cpp/.h,
+ * DMAOutput.cpp/.h, Fader.cpp/.h, FadeAndWipe.cpp/.h, FrameLayer.cpp/.h, FrameSource.h,
+ * NetworkOutput.cpp/.h, PaletteFrame.cpp/.h, Particles.cpp/.h,
+ * EventLog.cpp/.h, IdleSleep.cpp/.h, LogEvents.h, PeriodicPattern.cpp/.h, PIR.cpp/.h,
+ * PixelMap.cpp/.h, Profiler.cpp/.h, ProfileZones.h, RenderAhead.cpp/.h,
+ * SettingsStore.cpp/.h, StairGeometry.cpp/.h, StairMachine.cpp/.h, StairZones.cpp/.h,
+ * StripOutput.cpp/.h, TraceLog.cpp/.h, TraceSpans.h, Twinkle.cpp/.h, ZipLine.cpp/.h
  * 
  * @section license License
  * 
@@ -43,10 +47,23 @@
 #include <Adafruit_DotStar.h>
 #include "PIR.h"
 #include "Animation.h"
+#include "AnimationArena.h"
 #include "FadeAndWipe.h"
 #include "Twinkle.h"
 #include "ZipLine.h"
 #include "ColorSwirl.h"
+#include "PaletteFrame.h"
+#include "StripOutput.h"
+#include "DMAOutput.h"
+#include "RenderAhead.h"
+#include "SettingsStore.h"
+#include "EventLog.h"
+#include "IdleSleep.h"
+#include "Profiler.h"                 // set kProfiling there to time the parts of loop()
+#include "TraceLog.h"                 // set kTracing there to capture a timeline of a slow loop()
+#include "StairMachine.h"
+#include "StairGeometry.h"
+#include "StairZones.h"
 #include "AnimationGlobals.h"         // defines # of LEDs in the string (among other things)
 
 bool debug = false;                   // set true for debugging output on Serial monitor
@@ -55,6 +72,21 @@ bool PIRDebug = false;                // set true when using switches for PIRs
 bool fadeDebug = false;               // true when no mode switch attached
 bool lightLevelDebug = false;         // when we don't have a light sensor connected
 
+// set kDMAOutput to 1 in DMAOutput.h to send frames with SPI/DMA (non-blocking) rather
+// than Adafruit_NeoPixel; the strip's data line must then be on the SPI MOSI pin, and
+// the SPI pins can't be used for anything else
+#define useDMAOutput kDMAOutput
+
+// set true to draw the frames of the steadier animations (Animation::Deterministic())
+// a few ahead of time; loop() then only has to send each one when it's due
+// (see RenderAhead.h). Costs 3 bytes per LED per frame kept.
+#define useRenderAhead false
+
+// set true to put the processor in standby when idle (see IdleSleep.h); it wakes
+// for PIR motion and for the next light level sample. Off until it has been
+// measured on a Trinket M0
+#define sleepWhenIdle false
+
 /************************************************************************************
  * GPIO pin definitions. We're using all of them on a trinket M0
  ************************************************************************************/
@@ -64,6 +96,14 @@ bool lightLevelDebug = false;         // when we don't have a light sensor conne
 #define BottomPIRPin  3               // lower PIR
 #define LightLevelPin 4               // for sensing the light level (analog in)
 
+#if useDMAOutput && defined(PIN_SPI_MOSI)
+// SPI.begin() takes MOSI, SCK & MISO (D4, D3 & D2 on a Trinket M0, whose only other
+// SERCOM pin is D0)
+#define isSPIPin(pin) (((pin) == PIN_SPI_MOSI) || ((pin) == PIN_SPI_SCK) || ((pin) == PIN_SPI_MISO))
+static_assert(!isSPIPin(TopPIRPin) && !isSPIPin(modePin) && !isSPIPin(BottomPIRPin) && !isSPIPin(LightLevelPin),
+              "DMAOutput needs the SPI pins; move the sensors off them first");
+#endif
+
 /************************************************************************************
  * light levels to used to decide which color to light the stairs
  ************************************************************************************/
@@ -76,8 +116,16 @@ int lightLevelDim = klightLevelDim;   // below this, a dimish red
 #define klightLevelTwinkleThreshold 600
 int lightLevelTwinkleThreshold = klightLevelTwinkleThreshold;  // separator between twinkle mode & fade mode
 
-#define minimumOnTime 10              // amount of time (seconds) LEDs stay on after 2nd PIR is triggered
-#define timeBetweenPIRTriggers 9      // time out period (seconds) when waiting for 2nd PIR to trip
+// the quickest & slowest trips up or down the stairs, minimumTraverseTime and
+// maximumTraverseTime, are in StairMachine.h where host/ParamSweep.cpp sees them too
+
+// set true to dim the steps a walker has left behind (ColorWipe); anyone else
+// coming onto the stairs brings them back up
+#define dimPassedStepsWhenWalking false
+
+// current the strip's supply can deliver (less some margin); brightness is lowered
+// when a frame would need more. 0 -> no limit
+#define powerBudgetMilliamps 3500
 
 /************************************************************************************
  * lots of LEDs to light stairs.
@@ -85,30 +133,64 @@ int lightLevelTwinkleThreshold = klightLevelTwinkleThreshold;  // separator betw
  ************************************************************************************/
 const int numberOfPixels = kNumberOfLEDs; // defined in AnimationGlobals
 
+PaletteFrame frame = PaletteFrame(numberOfPixels);   // animations draw here, expanded by stripOutput
+
+// how the strip is wired: runs of pixels in step order (bottom first) and where
+// each starts on the strip. One run from LED 0 up is a strip wired in step order.
+// A strip fed from the middle would be
+//   { 0, 55, 54, true }, { 55, 56, 55, false }
+// and strip LEDs no run covers (under a landing, say) are left dark
+const PixelRun stripRuns[] = {
+  { 0, numberOfPixels, 0, false }     // first pixel, # of pixels, first strip LED, reversed
+};
+PixelMap pixelMap;
+StairGeometry geometry;                               // steps between the indicators, kStairSteps of them
+#if useDMAOutput
+DMAOutput stripOutput;                                // frame -> bitstreams -> SPI, no NeoPixel buffer needed
+#else
 Adafruit_NeoPixel pixels = Adafruit_NeoPixel(numberOfPixels, NeoPixelsPin, NEO_GRB + NEO_KHZ800);
+NeoPixelOutput stripOutput = NeoPixelOutput(pixels);
+#endif
+#if useRenderAhead
+RenderAhead renderAhead = RenderAhead(stripOutput);   // frames prepared ahead, then sent to stripOutput
+#endif
 Adafruit_DotStar dot = Adafruit_DotStar(1, INTERNAL_DS_DATA, INTERNAL_DS_CLK, DOTSTAR_BGR);
 
 PIR topPIR = PIR(TopPIRPin, numberOfPixels-1, "top", PIRDebug);
 PIR bottomPIR = PIR(BottomPIRPin, 0, "bottom", PIRDebug);
 
+// the PIRs from the bottom of the stairs to the top. A PIR on a landing goes in
+// between, its indicator the LED where one flight's LEDs end and the next begin,
+// and each flight needs its handler & machine (see flightMachines[])
+PIR * const zonePIRs[] = {
+  &bottomPIR,
+  &topPIR
+};
+StairZones zones = StairZones(zonePIRs, tableCount(zonePIRs));
+extern StairMachine flightMachines[];     // one for each flight, after their handlers
+
 // define some named colors for use in the code
-uint32_t onColor = pixels.Color(255, 255, 255);      // color to use for ON
-uint32_t offColor = pixels.Color(0, 0, 0);           // color to use for OFF
-uint32_t indicatorColor = pixels.Color(10, 10, 10);  // color to use for indicator LEDs
-uint32_t dimRed = pixels.Color(75, 0, 0);
-uint32_t dimPaleBlue = pixels.Color(50, 50, 128);
+const uint32_t onColor = rgbColor(255, 255, 255);    // color to use for ON
+const uint32_t offColor = rgbColor(0, 0, 0);         // color to use for OFF
+const uint32_t indicatorColor = rgbColor(10, 10, 10);  // color to use for indicator LEDs
+const uint32_t dimRed = rgbColor(75, 0, 0);
+const uint32_t dimPaleBlue = rgbColor(50, 50, 128);
+const uint32_t warmingUpColor = rgbColor(128, 96, 0);  // PIR not settled yet (alert layer)
 
 // below are used to attempt to normalize readings from the light sensors
 int lastLevel = 0;                // last actual light level reading (use when LEDs on)
 int lightLevelMin = 1024;         // lowest light level seend during some period
 int lightLevelMax = 0;            // highest light level seen during some period
 unsigned long LightLevelSamplingStartTime = 0;
+#define lightSampleTime (1000*10)     // ms between light level samples
+
+IdleSleep idleSleep;                  // now() is the time of day: millis() stops in standby
 
 /************************************************************************************
  * attempt to rescale the light thresholds based on readings seen over some time period
  ************************************************************************************/
 void remapLightLevelThresholds() {
-    if (debug) { Serial.println("remapLightLevelThresholds"); }
+    LOG_EVENT(evRemapThresholds, lightLevelMin, lightLevelMax);
     lightLevelBright = map(klightLevelBright, 0, 1024, lightLevelMin, lightLevelMax);
     lightLevelMedium = map(klightLevelMedium, 0, 1024, lightLevelMin, lightLevelMax);
     lightLevelDim = map(klightLevelDim, 0, 1024, lightLevelMin, lightLevelMax);
@@ -121,7 +203,7 @@ void remapLightLevelThresholds() {
 bool fadingMode() {
   if (fadeDebug) {
     bool debugResult = (random(4873823) & 1) == 0;
-    Serial.print("debugFadeMode: "); Serial.println(debugResult);
+    LOG_EVENT(evDebugFadeMode, debugResult, 0);
     return debugResult;
   }
   return (digitalRead(modePin) == LOW);
@@ -181,11 +263,12 @@ void blinkActive(unsigned long now, bool useDotStar=false) {
 }
 
 /************************************************************
- * simple state machine for implementation
+ * start up runs first (see executeBoot()), then the stairs'
+ * state machine (StairMachine.h) takes over
  ***********************************************************/
-enum SystemState { idleState, topTriggeredState, bottomTriggeredState, waitingTimeoutState, failedTimeoutState };
+enum BootState { bootShowState, bootSettleState, bootDoneState };
 
-SystemState currentState = idleState;
+BootState bootState = bootShowState;
 
 /************************************************************
  *  create objects for the various animations
@@ -195,31 +278,37 @@ ZipLine zipLine = ZipLine("ZipLine", 2.0);
 ColorSwirl colorSwirl = ColorSwirl("Rainbow", -15);
 SingleSwirl singleSwirl = SingleSwirl("Fading colors", -15);
 Marquee marquee = Marquee("Marquee", -150);
-FadeToColor fadeToColor = FadeToColor("Fade to color", 1.3);
+FadeToColor fadeToColor = FadeToColor("Fade to color", kFadeToColorTime);
 ZipLineInverse zipLineInverse = ZipLineInverse("ZipLine Inverse", 2.0);
 Twinkle twinkle = Twinkle("Twinkle", 1.75);
 Startup sup = Startup("Startup", 1.5);
 Zip2 zip2 = Zip2("Zip2", 2.0);
 Zip2Inverse zip2i = Zip2Inverse("Zip 2 inverse", 2.0);
 ZipR zipR = ZipR("Zip Random", 1.75);
+Walkers walkers = Walkers("Walkers", 6.0, 8);
 
+/************************************************************
+ *  animation tables. These are constant (so they stay in flash)
+ *  and the counts are worked out by the compiler, so adding an
+ *  animation is just adding a line to a table
+ ***********************************************************/
 // animations to use when mode switch is LOW
-#define nonFadeDimAnimationCount 2   // number used in LOW mode
-Animation * nonFadeDimAnimations[nonFadeDimAnimationCount] = {
+Animation * const nonFadeDimAnimations[] = {
   &colorWipe,
   &sup
 };
+const int nonFadeDimAnimationCount = tableCount(nonFadeDimAnimations);  // number used in LOW mode
 
-#define nonFadeBrighterAnimationCount 3   // number used in LOW mode
-Animation * nonFadeBrighterAnimations[nonFadeBrighterAnimationCount] = {
+Animation * const nonFadeBrighterAnimations[] = {
   &zipLine,
   &zip2,
-  &zipR
+  &zipR,
+  &walkers
 };
+const int nonFadeBrighterAnimationCount = tableCount(nonFadeBrighterAnimations);  // number used in LOW mode
 
 // animations to use when mode switch is HIGH
-#define fadeHighAnimationCount 9  // number used in HI mode
-Animation * fadeHighAnimations[fadeHighAnimationCount] = {
+Animation * const fadeHighAnimations[] = {
   &singleSwirl,
   &twinkle,
   &colorSwirl,
@@ -230,30 +319,118 @@ Animation * fadeHighAnimations[fadeHighAnimationCount] = {
   &colorWipe,
   &zip2i
  };
+const int fadeHighAnimationCount = tableCount(fadeHighAnimations);  // number used in HI mode
+
+static_assert(tableCount(nonFadeDimAnimations) > 0, "no dim animations");
+static_assert(tableCount(nonFadeBrighterAnimations) > 0, "no brighter animations");
+static_assert(tableCount(fadeHighAnimations) > 0, "no fade animations");
 
 // currently active animation - initialize to something
 Animation *currentAnimation = fadeHighAnimations[fadeHighAnimationCount-1];
 
-// display to show at startup - displays all of entries in colors[]
-void startupShowColors() {
-  bool topToBottom = false;
-  for (int i=0; i<4; i++) {     // repeat a few times
-    unsigned long started = millis();
-    unsigned long now = started;
-    sup.Start(topToBottom, 1);
-    do {
-      now = millis();
-      sup.Continue();           // continue & wait
-      blinkActive(now);
-    } while ((now-started) < 2500);
-    started = now;
-    sup.Finish(topToBottom);   // finish then wait a bit
-    do {
-      now = millis();
-      sup.Continue();
-      blinkActive(now);
-    } while ((now-started) < 2500);
-    topToBottom = !topToBottom;
+/************************************************************************************
+ * start up. Nothing here waits: the startup show (all of the entries in colors[])
+ * is just the current animation while in bootShowState, run by loop() like any
+ * other, and motion seen meanwhile ends it and is served straight away.
+ * A PIR's output is HIGH for a while after power up, so until a PIR has been seen
+ * LOW its HIGH isn't believed (see loop()). bootSettleState waits, blinking the
+ * dotstar and the indicator LED of any PIR that hasn't settled by the end of the
+ * show (on the alert layer, so it's seen over the indicator itself).
+ ************************************************************************************/
+#define bootShowRounds 4              // times the show runs, alternating directions
+#define bootShowPhaseTime 2500        // ms spent lighting, then clearing, each round
+#define bootBlinkTime 250             // dotstar blink period while waiting for PIRs
+
+int bootRound = 0;
+bool bootClearing = false;            // in the clearing half of a round?
+bool bootTopToBottom = false;
+unsigned long bootPhaseStart = 0;
+unsigned long bootBlinkLastTime = 0;
+bool bootBlinkState = false;
+
+void startBootShow(unsigned long now) {
+  currentAnimation = &sup;
+  sup.Start(bootTopToBottom, 1);
+  bootPhaseStart = now;
+  bootState = bootShowState;
+}
+
+// the show has run its course; if a PIR is still warming up, wait for it
+void finishBootShow(unsigned long now) {
+  if (zones.allSettled()) {
+    Serial.println("Ready");
+    bootState = bootDoneState;
+    return;
+  }
+  Serial.print("Waiting for PIRs to stablize:");
+  for (int z=0; z<zones.zones(); z++) {
+    if (!zones.settled(z)) {
+      Serial.print(" "); Serial.print(zones.sensor(z).PIRName);
+    }
+  }
+  Serial.println();
+  if (debugPattern) {
+    Serial.println("  Started in debugPattern mode");
+    setIndicator(64, 92, 64);
+    currentAnimation = &zipLine;
+    zipLine.Start(true, zipLine.randomColor()); // start pattern we're debugging
+    bootState = bootDoneState;
+    return;
+  }
+  bootBlinkLastTime = now;
+  bootState = bootSettleState;
+}
+
+void executeBoot(bool motion, uint32_t now) {
+  if (motion) {                           // motion from a settled PIR: drop the show, serve it
+    LOG_EVENT(evMotionDuringBoot, 0, 0);
+    frame.fill(offColor);
+    frame.layer(kAlertLayer).clear();
+    setIndicator(0, 0, 0);
+    bootState = bootDoneState;
+    return;
+  }
+  if (bootState == bootShowState) {
+    if ((now - bootPhaseStart) < bootShowPhaseTime) {
+      return;
+    }
+    bootPhaseStart = now;
+    if (!bootClearing) {
+      sup.Finish(bootTopToBottom);        // clear it again
+      bootClearing = true;
+      return;
+    }
+    bootClearing = false;
+    bootTopToBottom = !bootTopToBottom;
+    bootRound += 1;
+    if (bootRound < bootShowRounds) {
+      sup.Start(bootTopToBottom, 1);
+    } else {
+      finishBootShow(now);
+    }
+    return;
+  }
+  if (zones.allSettled()) {               // bootSettleState
+    setIndicator(0, 0, 0);
+    frame.layer(kAlertLayer).clear();
+    frame.show();
+    Serial.println("Ready");
+    bootState = bootDoneState;
+  } else if ((now - bootBlinkLastTime) >= bootBlinkTime) {
+    FrameLayer &alert = frame.layer(kAlertLayer);
+    uint32_t blinkColor = bootBlinkState ? offColor : warmingUpColor;
+    for (int z=0; z<zones.zones(); z++) {   // blink the PIR(s) we're waiting for
+      alert.setPixelColor(zones.sensor(z).indicator(), zones.settled(z) ? offColor : blinkColor);
+    }
+    frame.show();
+    if (bootBlinkState) {                 // blink dotstar while waiting
+      dot.setPixelColor(0, 0, 0, 0);
+    } else {
+      dot.setPixelColor(0, 128, 96, 0);
+    }
+    dot.show();
+    bootBlinkState = !bootBlinkState;
+    bootBlinkLastTime = now;
   }
 }
 
@@ -263,16 +440,19 @@ void startupShowColors() {
  *   if the level hasn't changed very much, hands back previous reading
  ************************************************************************************/
 int getLightLevel() {
+  PROFILE_ZONE(zoneLightLevel);
   if (lightLevelDebug) {
     int debugResult = random(986342) & 1 ? lightLevelBright : lightLevelDim;
-    Serial.print("debugLightLevel: "); Serial.println(debugResult);
+    LOG_EVENT(evDebugLightLevel, 0, debugResult);
     return debugResult;
   }
   if (currentAnimation->Active()) {
-    if (debug) { Serial.println("currentAnimation->Active() == true"); }
+    LOG_EVENT(evLightLevelSkipped, 0, lastLevel);
     return lastLevel;             // LEDS being will likely foul the reading, just return last one
   }
+  TRACE_BEGIN(trLightLevel, 0);
   int level = analogRead(LightLevelPin);
+  TRACE_END(trLightLevel, 0, level);
   if (level > lightLevelMax) {    // track max and min values we've seen over some period
     lightLevelMax = level;
   }
@@ -280,7 +460,7 @@ int getLightLevel() {
     lightLevelMin = level;
   }
   if (abs(level-lastLevel) > 3) { // did it change much?
-    if (debug) { Serial.print("light level: "); Serial.println(level); }
+    LOG_EVENT(evLightLevel, 0, level);
     lastLevel = level;
   }
   return level;
@@ -301,8 +481,8 @@ uint32_t colorBasedOnConditions() {
   uint32_t theColor = currentAnimation->randomColor();
   if (!fadingMode()) {         // mode pin in fade mode?
     if (currentAnimation == &colorWipe) {
-      if (debug) { Serial.println("Fading mode && ColorWipe"); }
       int lightLevel = getLightLevel();
+      LOG_EVENT(evFadingColorWipe, 0, lightLevel);
       if (lightLevel > lightLevelBright) {
         theColor = offColor;
       }
@@ -333,6 +513,7 @@ void chooseAnimation() {
     }
     animationFadeIndex = animationFadeIndex % fadeHighAnimationCount;
     currentAnimation = fadeHighAnimations[animationFadeIndex];
+    LOG_EVENT(evAnimationChosen, 0, animationFadeIndex);
     previousAnimationFadeIndex = animationFadeIndex;
   } else {    // in this mode, we take light level into account choosing an animation
     int lvl = getLightLevel();
@@ -342,12 +523,14 @@ void chooseAnimation() {
         animationIndex = (animationIndex+1) % nonFadeBrighterAnimationCount;
       }
       currentAnimation = nonFadeBrighterAnimations[animationIndex];
+      LOG_EVENT(evAnimationChosen, 2, animationIndex);
     } else {                          // less bright
       animationIndex = myRandom(nonFadeDimAnimationCount);
       if (animationIndex == previousAnimationIndex) {
         animationIndex = (animationIndex+1) % nonFadeDimAnimationCount;
       }
       currentAnimation = nonFadeDimAnimations[animationIndex];
+      LOG_EVENT(evAnimationChosen, 1, animationIndex);
     }
     previousAnimationIndex = animationIndex;
   }
@@ -358,10 +541,71 @@ void chooseAnimation() {
 unsigned long lastLightReadTime = 0;
 bool firstDay = true;
 
+/************************************************************************************
+ * the light calibration takes a day to settle, so it's kept in flash and picked up
+ * again after a reset. It's saved when the thresholds are remapped and when the
+ * range seen moves noticeably, not on a timer, to spare the flash.
+ ************************************************************************************/
+#define calibrationSaveChange 8       // min or max moved this much -> worth saving
+
+struct LightCalibration {
+  int16_t levelMin;                   // lightLevelMin & Max
+  int16_t levelMax;
+  int16_t bright;                     // the thresholds remapped from them
+  int16_t medium;
+  int16_t dim;
+  int16_t twinkle;
+  uint16_t samplingMinutes;           // how far into the current sampling period
+  uint8_t firstDay;
+  uint8_t unused;
+};
+
+SettingsStore settingsStore;
+LightCalibration savedCalibration;    // as last saved (or restored)
+
+void saveCalibration(unsigned long now) {
+  LightCalibration calibration;
+  memset(&calibration, 0, sizeof(calibration));
+  calibration.levelMin = lightLevelMin;
+  calibration.levelMax = lightLevelMax;
+  calibration.bright = lightLevelBright;
+  calibration.medium = lightLevelMedium;
+  calibration.dim = lightLevelDim;
+  calibration.twinkle = lightLevelTwinkleThreshold;
+  calibration.samplingMinutes = (now - LightLevelSamplingStartTime) / (1000UL*60);
+  calibration.firstDay = firstDay;
+  if (settingsStore.save(&calibration, sizeof(calibration))) {
+    savedCalibration = calibration;
+    LOG_EVENT(evCalibrationSaved, 0, settingsStore.writes());
+  }
+}
+
+void restoreCalibration(unsigned long now) {
+  settingsStore.begin();
+  LightCalibration calibration;
+  if (!settingsStore.load(&calibration, sizeof(calibration))) {
+    memset(&savedCalibration, 0, sizeof(savedCalibration));
+    Serial.println("No saved light calibration");
+    return;
+  }
+  savedCalibration = calibration;
+  lightLevelMin = calibration.levelMin;
+  lightLevelMax = calibration.levelMax;
+  lightLevelBright = calibration.bright;
+  lightLevelMedium = calibration.medium;
+  lightLevelDim = calibration.dim;
+  lightLevelTwinkleThreshold = calibration.twinkle;
+  firstDay = calibration.firstDay;
+  LightLevelSamplingStartTime = now - calibration.samplingMinutes*(1000UL*60);  // wraps, that's fine
+  Serial.print("Restored light calibration, "); Serial.print(lightLevelMin);
+  Serial.print(".."); Serial.println(lightLevelMax);
+}
+
 void processLightLevel(unsigned long now) {
   if (firstDay && (now-LightLevelSamplingStartTime) > 1000*60*30) {
     remapLightLevelThresholds();
     LightLevelSamplingStartTime = now;
+    saveCalibration(now);
   }
   if ((now-LightLevelSamplingStartTime) > 1000*60*60*24) {
     remapLightLevelThresholds();
@@ -369,46 +613,73 @@ void processLightLevel(unsigned long now) {
     lightLevelMin = 1024;
     lightLevelMax = 0;
     firstDay = false;
+    saveCalibration(now);
   }
-  if ((now-lastLightReadTime) > 1000*10) {
+  if ((now-lastLightReadTime) > lightSampleTime) {
     getLightLevel();         // to build round the clock samples
     lastLightReadTime = now;
+    if ((abs(lightLevelMin - savedCalibration.levelMin) >= calibrationSaveChange) ||
+        (abs(lightLevelMax - savedCalibration.levelMax) >= calibrationSaveChange)) {
+      saveCalibration(now);
+    }
   }
 }
 
 // externally used function to map current light level to an appropriate brightness
 int mappedBrightness() {
-  int brightness = map(getLightLevel(), lightLevelMin, lightLevelMax, 64, 255);
-  if (debug) { 
-    Serial.print("mappedBrightness "); Serial.print(getLightLevel());
-    Serial.print(" -> "); Serial.println(brightness);
-  }
+  int level = getLightLevel();
+  int brightness = map(level, lightLevelMin, lightLevelMax, 64, 255);
+  LOG_EVENT(evMappedBrightness, brightness, level);
   return brightness;
 }
 
+// externally used function, the animations' clock; ahead of millis() while
+// RenderAhead is drawing frames before they're due
+unsigned long animationMillis() {
+#if useRenderAhead
+  return renderAhead.clock();
+#else
+  return millis();
+#endif
+}
+
 
 /************************************************************************************
  * Standard setup function
  * initializes Serial, pixels, dotstar
- * does a display on the LED strip
- * and then waits for the PIRs to both got to idle state
+ * and starts the start up display on the LED strip; it returns straight away,
+ * loop() runs the display and waits for the PIRs (see executeBoot())
  ************************************************************************************/
 void setup() {
   Serial.begin(115200);         // setup serial
-  pixels.begin();               // setup the pixel strip
-  pixels.show();
+#if useRenderAhead
+  renderAhead.begin();          // setup the pixel strip, with frames prepared ahead going to it
+  frame.setOutput(&renderAhead);
+#else
+  stripOutput.begin();          // setup the pixel strip
+  frame.setOutput(&stripOutput);
+#endif
+  if (!pixelMap.begin(stripRuns, tableCount(stripRuns), numberOfPixels)) {
+    Serial.println("stripRuns[] doesn't fit the strip; sending pixels in step order");
+  }
+  if (!pixelMap.identity()) {
+    frame.setPixelMap(&pixelMap);
+  }
+  frame.setPowerBudget(powerBudgetMilliamps);
+  frame.begin();
+  frame.layer(kOverlayLayer).setBlend(addBlend);  // PIR indicators show on lit LEDs too
+  frame.layer(kAlertLayer).setBlend(replaceBlend);
+  frame.show();
+  geometry.begin(1, numberOfPixels-2);  // (or geometry.setSteps() with a table of steps & landings)
+  colorWipe.dimPassedSteps = dimPassedStepsWhenWalking;
 
   pinMode(modePin, INPUT_PULLUP);
 
-  for (int i=0; i<10; i++) {    // wait a bit for serial to sych up
-    Serial.print(".");
-    delay(250);
-  }
-  Serial.println("");
   Serial.print("Starting with "); Serial.print(fadeHighAnimationCount); Serial.print(" fade animations, ");
   Serial.print(nonFadeDimAnimationCount); Serial.print(" dim & "); Serial.print(nonFadeBrighterAnimationCount); 
   Serial.print(" brighter non-fade animations, and ");
-  Serial.print(pixels.numPixels()); Serial.println(" LEDs");
+  Serial.print(frame.numPixels()); Serial.print(" LEDs, ");
+  Serial.print(animationArena.capacity()); Serial.println(" bytes of animation state");
 
 // if set true, print out debugging states so we know what we're running
   if (topPIR.debugMode()) { Serial.println("  >> Main: PIRDebug == true"); }
@@ -417,160 +688,300 @@ void setup() {
   if (fadeDebug) { Serial.println("  >> Main: fadeDebug == true"); }
   if (lightLevelDebug) {Serial.println("  >> Main: lightLevelDebug == true"); }
 
-  pixels.fill(offColor);        // blank neopixel display
-
-  bool top, bottom;
-  bool state = false;
-  top = topPIR.read();          // prime the pump so first real call is accurate
-  bottom = bottomPIR.read();
+  frame.fill(offColor);         // blank neopixel display
 
-  startupShowColors();
-  randomSeed(analogRead(4));
-  if (top || bottom) {          // either PIR in active state?
-    Serial.print("Waiting for PIRs to stablize, top: "); Serial.print(top); Serial.print(" bottom: "); Serial.println(bottom);
-    if (!debugPattern) {
-      do {                        // check the PIR states until they are both "false" (stabilized)
-        delay(250);
-        if (state) {              // blink dotstar while waiting
-          dot.setPixelColor(0, 0, 0, 0);
-        } else {
-          dot.setPixelColor(0, 128, 96, 0);
-        }
-        dot.show();
-        state = !state;
-        top = topPIR.read();
-        bottom = bottomPIR.read();
-      } while (top || bottom);
-      setIndicator(0, 0, 0);
-    } else {
-      Serial.println("  Started in debugPattern mode");
-      setIndicator(64, 92, 64);
-      zipLine.Start(true, zipLine.randomColor()); // start pattern we're debugging
-    }
+  restoreCalibration(millis());
+  int zonePins[kMaxPIRZones];
+  for (int z=0; z<zones.zones(); z++) {
+    zones.sensor(z).read();     // prime the pump so first real call is accurate
+    zonePins[z] = zones.sensor(z).pin();
   }
-  Serial.println("Ready");
+  for (int f=0; f<zones.flights(); f++) {
+    zones.setFlight(f, flightMachines[f]);
+  }
+  idleSleep.begin(zonePins, zones.zones(), topPIR.debugMode() ? LOW : HIGH);
+#if kProfiling
+  profiler.begin();
+#endif
+  randomSeed(analogRead(4));
+  startBootShow(millis());      // loop() takes it from here
+  Serial.print("Running after "); Serial.print(millis()); Serial.println(" ms");
 }
 
 /************************************************************************************
- * Helper functions for the state machine execution
- * handles code essentially duplicated otherwise
- * hopefully makes
+ * what the state machine's actions do to the lights - uses Trinket M0 dotstar to
+ * display the current state
+ *
+ * DotStar color indicators for debugging
+ * RED - top PIR tripped
+ * GREEN - bottom PIR tripped
+ * BLUE - top then bottom PIRs tripped
+ * PALE BLUE - top tripped, timed out waiting for bottom PIR
+ * MAGENTA - bottom then top PIRs tripped
+ * YELLOW - bottom tripped, timed out waiting for top PIR
+ * BLACK - idle state (other state colors are set BLACK after 30 seconds)
  ************************************************************************************/
-unsigned long onTime = 0;     // remember time we turned leds on
-bool startedAtTop = false;    // remember if the PIR at the top tripped first (used rather than expanding the state machine)
-bool prevTop = false;
-bool prevBot = false;
+int animatedFlight = -1;                  // flight currentAnimation is running on
+bool flightLit[kMaxFlights];              // lightsOn() without lightsOff() since
+
+class FlightHandler : public StairHandler {
+  public:
+    FlightHandler(int flight) : _flight(flight) {}
+    void lightsOn(bool fromTop, uint32_t now);
+    void lightsOff(bool fromTop, uint32_t now);
+    void occupancyChanged(OccupancyChange change, bool fromTop, int count, uint32_t walked, uint32_t now);
+
+  private:
+    int _flight;                            // 0 is the bottom one
+    bool _lighting = false;                 // the entry being told about turned the lights on
+};
+
+// between the flight's PIRs' indicators
+void fillFlight(int flight, uint32_t aColor) {
+  int count = zones.lastLED(flight) - zones.firstLED(flight) - 1;
+  if (count > 0) {
+    frame.fill(aColor, zones.firstLED(flight)+1, count);
+    frame.show();
+  }
+}
 
-void firstSensorTripped(int nextState, bool fromTop, uint32_t now, int iRed, int iBlue, int iGreen) {
+// the animation runs on the flight people are heading onto (StairZones::activeFlight(),
+// from the landing PIRs), starting from the end they came from. A flight lit while
+// the animation is busy with one people aren't heading onto is just filled with a
+// color; the one it moves away from keeps a fill while it's lit
+void FlightHandler::lightsOn(bool fromTop, uint32_t now) {
+  (void)now;
+  _lighting = true;
+  flightLit[_flight] = true;
+  bool headingHere = (zones.activeFlight() == _flight);
+  if (headingHere && (zones.direction() != 0)) {
+    fromTop = (zones.direction() < 0);
+  }
+  if ((animatedFlight >= 0) && (animatedFlight != _flight) &&
+      (flightLit[animatedFlight] || currentAnimation->Active())) {
+    if (!headingHere) {
+      fillFlight(_flight, colorBasedOnConditions());
+      return;
+    }
+    fillFlight(animatedFlight, flightLit[animatedFlight] ? colorBasedOnConditions() : offColor);
+  }
+  animatedFlight = _flight;
   chooseAnimation();                        // select an animation to use
-  setIndicator(iRed, iBlue, iGreen);        // set indicator so state can be observed
-  startedAtTop = fromTop;                   // how pattern started
-  onTime = now;                             // when it started
   if (debug) { currentAnimation->printSelf(); }
+  currentAnimation->setSegment(zones.firstLED(_flight), zones.lastLED(_flight));
   currentAnimation->Start(fromTop, colorBasedOnConditions()); // and start animation going
-  currentState = SystemState(nextState);    // this (and the int parameter) are a hack to avoid an
-                                            // arduino compile time problem
-}
-
-void secondSensorTripped(uint32_t now, int iRed, int iBlue, int iGreen) {
-  setIndicator(iRed, iGreen, iBlue);        // observable state info
-  onTime = now;
-  currentState = waitingTimeoutState;       // next state
 }
 
-void noSecondSensor(bool fromTop, int iRed, int iGreen, int iBlue) {
-  setIndicator(iRed, iGreen, iBlue);        // observable state info
+// the last one has gone; the animation follows them out (or goes back the way it
+// came for someone who turned back)
+void FlightHandler::lightsOff(bool fromTop, uint32_t now) {
+  (void)now;
+  LOG_EVENT(evTimeoutDone, fromTop, _flight);
+  flightLit[_flight] = false;
+  if (animatedFlight != _flight) {
+    fillFlight(_flight, offColor);
+    return;
+  }
+  setIndicator(0, 0, 0);
   currentAnimation->Finish(fromTop);        // start the animation in Finish phase
-  currentState = failedTimeoutState;        // and next state
+#if useRenderAhead
+  if (debug) { renderAhead.printStats(); }
+#endif
 }
 
-/************************************************************************************
- * state machine execution - uses Trinket M0 dotstar to display current state
- * 
- * DotStar color indicators for debugging
- * RED - top PIR tripped
- * GREEN - bottom PIR tripped
- * BLUE - top then bottom PIRs tripped
- * PALE BLUE - top tripped, timed out waiting for bottom PIR
- * MAGENTA - bottom then top PIRs tripped
- * YELLOW - bottom tripped, timed out waiting for top PIR
- * BLACK - idle state (other state colors are set BLACK after 30 seconds)
- ************************************************************************************/
-void executeStateMachine(bool top, bool bottom, uint32_t now) {
-   switch (currentState) {
-    case idleState:                       // waiting for a PIR to sense motion
-      if (top) {
-        if (debug) { Serial.println("-> top triggered"); }
-        firstSensorTripped(topTriggeredState, true, now, 128, 0, 0);
-      } else if (bottom) {
-        if (debug) { Serial.println("-> bottom Triggered"); }
-        firstSensorTripped(bottomTriggeredState, false, now, 0, 128, 0);
+void FlightHandler::occupancyChanged(OccupancyChange change, bool fromTop, int count, uint32_t walked,
+                                     uint32_t now) {
+  (void)now;
+  (void)count;                              // only logged, and the log can be compiled out
+  switch (change) {
+    case walkerEntered:
+      if (!_lighting && (animatedFlight == _flight)) {
+        currentAnimation->Joined(fromTop);  // lights already on for someone else
       }
-      break;
-    case topTriggeredState:               // top saw motion, wait for timeout, or bottom PIR
-      if (bottom) {                       // now bottom saw motion
-        if (debug) { Serial.println("-> waitingTimeout top"); }
-        secondSensorTripped(now, 0, 0, 128);
-      } else {                            // lower PIR not triggered yet; timeout yet?
-        if (((now - onTime)/1000 >= timeBetweenPIRTriggers) /*|| !top*/) {  // maybe comment out "|| !top"
-                                                                        // which forces lights to stay on for time
-                                                                        // period rather than when the PIR goes LOW
-          if (debug) { Serial.println("-> idle - no bottom trigger"); }
-          noSecondSensor(!startedAtTop, 50, 50, 80);
-        }
-      }
-     break;
-    case bottomTriggeredState:            // bottom saw motion first
-      if (top) {                          // top see anything yet?
-        if (debug) { Serial.println("-> waitingTimeout bottom"); }
-        secondSensorTripped(now, 128, 0, 128);
-      } else {                            // upper hasn't tripped yet, timeout yet?
-        if (((now - onTime)/1000 >= timeBetweenPIRTriggers) /*|| !bottom*/) { // maybe comment out "|| !bottom"
-                                                                          // which forces lights to stay on for time
-                                                                          // period rather than when the PIR goes LOW
-          if (debug) { Serial.println("-> idle - no top trigger"); }
-          noSecondSensor(!startedAtTop, 80, 80, 0);
-        }
+      _lighting = false;
+      if (fromTop) {
+        LOG_EVENT(evTopTriggered, count, _flight);
+        setIndicator(128, 0, 0);
+      } else {
+        LOG_EVENT(evBottomTriggered, count, _flight);
+        setIndicator(0, 128, 0);
       }
-     break;
-    case waitingTimeoutState:             // both PIRs sensed motion, wait for both 
-                                          // to reset & time to elapse
-      if ((!top) && (!bottom) && (((now - onTime)/1000) >= minimumOnTime)) {
-        if (debug) { 
-          Serial.print("-> waitingTimeout - done; top: "); Serial.print(top);
-          Serial.print(" bottom: "); Serial.println(bottom); Serial.println(" "); 
-        }
-        setIndicator(0, 0, 0);
-        currentAnimation->Finish(startedAtTop);
-        currentState = idleState;
+      break;
+    case walkerLeft:
+      geometry.walked(walked, geometry.strides(zones.firstLED(_flight), zones.lastLED(_flight)));
+      if (fromTop) {
+        LOG_EVENT(evTopThenBottom, count, _flight);
+        setIndicator(0, 0, 128);
+      } else {
+        LOG_EVENT(evBottomThenTop, count, _flight);
+        setIndicator(128, 0, 128);
       }
       break;
-    case failedTimeoutState:              // only one sensor saw motion
-      if ((!top) && (!bottom)) {          // reset to idle at some point
-        currentState = idleState;
+    case walkerLost:
+      if (fromTop) {
+        LOG_EVENT(evNoBottomTrigger, count, _flight);
+        setIndicator(50, 50, 80);
+      } else {
+        LOG_EVENT(evNoTopTrigger, count, _flight);
+        setIndicator(80, 80, 0);
       }
       break;
   }
 }
 
+// one for each flight, the bottom one first
+FlightHandler flightHandlers[] = {
+  FlightHandler(0)
+};
+StairMachine flightMachines[] = {
+  StairMachine(flightHandlers[0], minimumTraverseTime*1000UL, maximumTraverseTime*1000UL)
+};
+static_assert(tableCount(flightMachines) == tableCount(zonePIRs)-1, "a flight between each pair of PIRs");
+static_assert(tableCount(flightHandlers) == tableCount(flightMachines), "a handler for each flight");
+static_assert(tableCount(zonePIRs) <= kMaxPIRZones, "too many PIRs");
+
+uint8_t prevLevels = 0;
+
+/************************************************************************************
+ * state machine execution: start up until that's done, then the stairs
+ ************************************************************************************/
+void executeStateMachine(uint8_t levels, uint32_t now) {
+  PROFILE_ZONE(zoneStateMachine);
+  if (bootState != bootDoneState) {
+    executeBoot(levels != 0, now);        // may finish, with motion for the stairs to serve
+    if (bootState != bootDoneState) {
+      return;
+    }
+  }
+  zones.update(now);
+}
+
+/************************************************************************************
+ * nothing to do until a PIR sees motion or the next light level sample is due, so
+ * sleep until then. Not while anything is lit or a PIR is (or is still reported)
+ * active.
+ ************************************************************************************/
+void sleepIfIdle(uint8_t levels, unsigned long now) {
+  if (!sleepWhenIdle || (bootState != bootDoneState) || !zones.idle() || currentAnimation->Active() ||
+      indicatorOn || (levels != 0)) {
+    return;
+  }
+#if useRenderAhead
+  if (!renderAhead.idle()) {              // the last frames are still to be sent
+    return;
+  }
+#endif
+  unsigned long sinceSample = now - lastLightReadTime;
+  if (sinceSample > lightSampleTime) {    // due now
+    return;
+  }
+  digitalWrite(13, LOW);                  // the active blink stays off while asleep
+  if (idleSleep.sleep(lightSampleTime + 1 - sinceSample)) {
+    LOG_EVENT(evWoken, idleSleep.wokenByPIR(), idleSleep.now() - now);
+  }
+}
+
+/************************************************************************************
+ * keep the animation going; with render-ahead the steadier ones are drawn up to
+ * kRenderAheadMillis before they're shown instead
+ ************************************************************************************/
+void continueAnimation() {
+  PROFILE_ZONE(zoneContinue);
+#if useRenderAhead
+  if (currentAnimation->Deterministic()) {
+    renderAhead.render(*currentAnimation, millis());
+    return;
+  }
+#endif
+  currentAnimation->Continue();
+}
+
+/************************************************************************************
+ * with kProfiling (Profiler.h) the time spent in each zone goes to Serial every
+ * profileReportTime, and the counting starts again
+ ************************************************************************************/
+#define profileReportTime (60*1000UL)
+
+unsigned long lastProfileReport = 0;
+
+void reportProfile(unsigned long now) {
+#if kProfiling
+  if ((now - lastProfileReport) >= profileReportTime) {
+    profiler.print(Serial);
+    profiler.reset();
+    lastProfileReport = now;
+  }
+#else
+  (void)now;
+#endif
+}
+
+/************************************************************************************
+ * with kTracing (TraceLog.h) a loop() that takes longer than traceSlowLoopTime
+ * freezes the trace around it, and the capture goes to Serial as fast as it can
+ * without waiting
+ ************************************************************************************/
+#define traceSlowLoopTime 20              // ms; frames are due every few
+
+void traceLoop(unsigned long started) {
+#if kTracing
+  unsigned long took = millis() - started;
+  if (took > traceSlowLoopTime) {
+    traceLog.trigger(took);
+  }
+  traceLog.drain(Serial);                 // send a few records of a waiting capture
+#else
+  (void)started;
+#endif
+}
+
+/************************************************************************************
+ * the event log only goes out on Serial when debug is set, and then only between
+ * animations, so the frames never wait on it; records logged meanwhile wait in the
+ * ring (or are counted as dropped)
+ ************************************************************************************/
+void drainEventLog() {
+#if kEventLogging
+  if (debug && !currentAnimation->Active()) {
+    PROFILE_ENTER(zoneLogDrain);
+    eventLog.drain(Serial);               // send a few of the records logged
+    PROFILE_EXIT(zoneLogDrain);
+  }
+#endif
+}
+
 /************************************************************************************
  * standard arduino loop() function
  ************************************************************************************/
 void loop() {
-  unsigned long now = millis();           // we'll eventually need this multiple times
+  PROFILE_ENTER(zoneLoop);
+  unsigned long loopStarted = millis();
+#if useRenderAhead
+  renderAhead.flush(millis());            // first, so a frame that's due goes out on time
+#endif
+  unsigned long now = idleSleep.now();    // we'll eventually need this multiple times
   processLightLevel(now);
   aRandomNumber = random(0, 9876543);     // do this a lot so that numbers end up being more randomish
-  bool top = topPIR.read();
-  bool bottom = bottomPIR.read();
-  if ((top != prevTop) || (bottom != prevBot)) {
-    if (debug) { Serial.print("PIR states top: "); Serial.print(top); Serial.print(", bot: "); Serial.println(bottom); }
-    prevTop = top;
-    prevBot = bottom;
+  uint8_t levels = zones.read(now);       // settled PIRs only
+  if (levels != prevLevels) {
+    LOG_EVENT(evPIRStates, levels, zones.direction());
+    prevLevels = levels;
   }
 
-  executeStateMachine(top, bottom, now);  // keep state machine going
+  executeStateMachine(levels, now);       // keep state machine going
 
-  currentAnimation->Continue();           // keep animation going
+  continueAnimation();                    // keep animation going
+  if (!zones.idle()) {                    // first frame for motion that woke us?
+    unsigned long latency = idleSleep.lit();
+    if (latency != 0) {
+      LOG_EVENT(evWakeToLight, 0, latency);
+    }
+  }
   indicatorContinue();                    // and any indicator in use
   blinkActive(now);                       // finally, blink red LED to say we're still running
+  drainEventLog();
+  PROFILE_EXIT(zoneLoop);                 // (not the sleep)
+  traceLoop(loopStarted);
+  reportProfile(now);
+  sleepIfIdle(levels, now);
 }